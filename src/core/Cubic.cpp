@@ -1,6 +1,7 @@
 #include "Cubic.hpp"
 #include <algorithm>
 #include <cmath>
+#include <limits>
 
 namespace RoundedPolygon {
 
@@ -223,6 +224,97 @@ Cubic Cubic::empty(float x0, float y0) {
     return Cubic(x0, y0, x0, y0, x0, y0, x0, y0);
 }
 
+namespace {
+
+// Number of samples taken along each cubic when comparing curves
+constexpr size_t DeviationSamples = 16;
+
+void appendSamples(const Cubic& cubic, size_t count, std::vector<Point>& out) {
+    for (size_t i = out.empty() ? 0 : 1; i <= count; ++i) {
+        out.push_back(cubic.pointOnCurve(
+            static_cast<float>(i) / static_cast<float>(count)));
+    }
+}
+
+float distanceToPolyline(const Point& p, const std::vector<Point>& polyline) {
+    float best = std::numeric_limits<float>::max();
+    for (size_t i = 0; i + 1 < polyline.size(); ++i) {
+        Point segment = polyline[i + 1] - polyline[i];
+        float lengthSquared = segment.getDistanceSquared();
+        float t = lengthSquared > 0.0f
+                      ? std::clamp((p - polyline[i]).dotProduct(segment) /
+                                       lengthSquared,
+                            0.0f, 1.0f)
+                      : 0.0f;
+        best = std::min(
+            best, (p - (polyline[i] + segment * t)).getDistanceSquared());
+    }
+    return std::sqrt(best);
+}
+
+} // anonymous namespace
+
+Cubic Cubic::merged(const std::vector<Cubic>& cubics) {
+    if (cubics.empty()) {
+        return Cubic();
+    }
+    const Cubic& first = cubics.front();
+    const Cubic& last = cubics.back();
+    Point start(first.anchor0X(), first.anchor0Y());
+    Point end(last.anchor1X(), last.anchor1Y());
+
+    // Tangents at the ends, skipping control points that sit on an anchor
+    Point startTangent = Point(first.control0X(), first.control0Y()) - start;
+    if (startTangent.getDistance() < DistanceEpsilon) {
+        startTangent = Point(first.control1X(), first.control1Y()) - start;
+    }
+    if (startTangent.getDistance() < DistanceEpsilon) {
+        startTangent = Point(first.anchor1X(), first.anchor1Y()) - start;
+    }
+    Point endTangent = end - Point(last.control1X(), last.control1Y());
+    if (endTangent.getDistance() < DistanceEpsilon) {
+        endTangent = end - Point(last.control0X(), last.control0Y());
+    }
+    if (endTangent.getDistance() < DistanceEpsilon) {
+        endTangent = end - Point(last.anchor0X(), last.anchor0Y());
+    }
+
+    // Handle lengths of a third of the run's length match straight runs
+    // exactly and gentle arcs closely
+    float length = 0.0f;
+    for (const auto& cubic : cubics) {
+        Point prev(cubic.anchor0X(), cubic.anchor0Y());
+        for (size_t i = 1; i <= 4; ++i) {
+            Point point = cubic.pointOnCurve(static_cast<float>(i) / 4.0f);
+            length += (point - prev).getDistance();
+            prev = point;
+        }
+    }
+    float handle = length / 3.0f;
+
+    return Cubic(start, start + startTangent.getDirection() * handle,
+        end - endTangent.getDirection() * handle, end);
+}
+
+float Cubic::deviation(
+    const std::vector<Cubic>& cubics, const Cubic& replacement) {
+    std::vector<Point> original;
+    for (const auto& cubic : cubics) {
+        appendSamples(cubic, DeviationSamples / 4, original);
+    }
+    std::vector<Point> approximation;
+    appendSamples(replacement, DeviationSamples, approximation);
+
+    float result = 0.0f;
+    for (const auto& p : original) {
+        result = std::max(result, distanceToPolyline(p, approximation));
+    }
+    for (const auto& p : approximation) {
+        result = std::max(result, distanceToPolyline(p, original));
+    }
+    return result;
+}
+
 // MutableCubic implementation
 
 void MutableCubic::transform(const PointTransformer& f) {
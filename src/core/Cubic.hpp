@@ -6,6 +6,7 @@
 #include "Utils.hpp"
 #include <array>
 #include <utility>
+#include <vector>
 
 namespace RoundedPolygon {
 
@@ -84,6 +85,15 @@ public:
         float centerX, float centerY, float x0, float y0, float x1, float y1);
     [[nodiscard]] static Cubic empty(float x0, float y0);
 
+    // Approximate a continuous run of cubics with a single cubic that keeps
+    // the run's end anchors and end tangents
+    [[nodiscard]] static Cubic merged(const std::vector<Cubic>& cubics);
+
+    // Maximum distance between a continuous run of cubics and a cubic that
+    // replaces it, measured on sampled points in both directions
+    [[nodiscard]] static float deviation(
+        const std::vector<Cubic>& cubics, const Cubic& replacement);
+
 protected:
     std::array<float, 8> m_points;
 };
@@ -0,0 +1,126 @@
+#include "OutlineShape.hpp"
+#include "PolygonBuilder.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace RoundedPolygon {
+
+OutlineShape::OutlineShape(const std::vector<float>& vertices,
+    const CornerRounding& rounding,
+    const std::vector<CornerRounding>* perVertexRounding, float centerX,
+    float centerY)
+    : m_vertices(vertices)
+    , m_sourceCenterX(centerX)
+    , m_sourceCenterY(centerY) {
+    // Validates the arguments like the RoundedPolygonShape constructor
+    PolygonBuilder builder(
+        vertices, rounding, perVertexRounding, centerX, centerY);
+    builder.outline(m_cubics);
+    m_center = builder.center();
+
+    m_roundings.reserve(builder.size());
+    for (size_t i = 0; i < builder.size(); ++i) {
+        m_roundings.push_back(builder.rounding(i));
+    }
+}
+
+OutlineShape::OutlineShape(int numVertices, float radius, float centerX,
+    float centerY, const CornerRounding& rounding,
+    const std::vector<CornerRounding>* perVertexRounding)
+    : OutlineShape(RoundedPolygonShape::verticesFromNumVerts(
+                       numVertices, radius, centerX, centerY),
+          rounding, perVertexRounding, centerX, centerY) {}
+
+OutlineShape OutlineShape::transformed(const PointTransformer& f) const {
+    OutlineShape result = *this;
+    for (auto& cubic : result.m_cubics) {
+        cubic = cubic.transformed(f);
+    }
+    result.m_center = ::RoundedPolygon::transformed(m_center, f);
+    if (m_transform) {
+        result.m_transform = [previous = m_transform, f](float x, float y) {
+            TransformResult point = previous(x, y);
+            return f(point.x, point.y);
+        };
+    } else {
+        result.m_transform = f;
+    }
+    return result;
+}
+
+OutlineShape OutlineShape::normalized() const {
+    auto bounds = calculateBounds();
+    float width = bounds[2] - bounds[0];
+    float height = bounds[3] - bounds[1];
+    float side = std::max(width, height);
+    float offsetX = (side - width) / 2.0f - bounds[0];
+    float offsetY = (side - height) / 2.0f - bounds[1];
+
+    return transformed([side, offsetX, offsetY](float x, float y) {
+        return TransformResult((x + offsetX) / side, (y + offsetY) / side);
+    });
+}
+
+void OutlineShape::calculateBounds(
+    std::array<float, 4>& bounds, bool approximate) const {
+    float minX = std::numeric_limits<float>::max();
+    float minY = std::numeric_limits<float>::max();
+    float maxX = std::numeric_limits<float>::lowest();
+    float maxY = std::numeric_limits<float>::lowest();
+
+    std::array<float, 4> cubicBounds;
+    for (const auto& cubic : m_cubics) {
+        cubic.calculateBounds(cubicBounds, approximate);
+        minX = std::min(minX, cubicBounds[0]);
+        minY = std::min(minY, cubicBounds[1]);
+        maxX = std::max(maxX, cubicBounds[2]);
+        maxY = std::max(maxY, cubicBounds[3]);
+    }
+
+    bounds[0] = minX;
+    bounds[1] = minY;
+    bounds[2] = maxX;
+    bounds[3] = maxY;
+}
+
+std::array<float, 4> OutlineShape::calculateBounds(bool approximate) const {
+    std::array<float, 4> bounds;
+    calculateBounds(bounds, approximate);
+    return bounds;
+}
+
+void OutlineShape::calculateMaxBounds(std::array<float, 4>& bounds) const {
+    float maxDistSquared = 0.0f;
+    for (const auto& cubic : m_cubics) {
+        float anchorDist = distanceSquared(
+            cubic.anchor0X() - m_center.x, cubic.anchor0Y() - m_center.y);
+        Point middlePoint = cubic.pointOnCurve(0.5f);
+        float middleDist = distanceSquared(
+            middlePoint.x - m_center.x, middlePoint.y - m_center.y);
+        maxDistSquared =
+            std::max(maxDistSquared, std::max(anchorDist, middleDist));
+    }
+
+    float dist = std::sqrt(maxDistSquared);
+    bounds[0] = m_center.x - dist;
+    bounds[1] = m_center.y - dist;
+    bounds[2] = m_center.x + dist;
+    bounds[3] = m_center.y + dist;
+}
+
+std::array<float, 4> OutlineShape::calculateMaxBounds() const {
+    std::array<float, 4> bounds;
+    calculateMaxBounds(bounds);
+    return bounds;
+}
+
+RoundedPolygonShape OutlineShape::shape() const {
+    RoundedPolygonShape shape(m_vertices, CornerRounding::Unrounded,
+        &m_roundings, m_sourceCenterX, m_sourceCenterY);
+    if (m_transform) {
+        return shape.transformed(m_transform);
+    }
+    return shape;
+}
+
+} // namespace RoundedPolygon
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "RoundedPolygon.hpp"
+#include <array>
+#include <limits>
+#include <vector>
+
+namespace RoundedPolygon {
+
+/**
+ * OutlineShape is a polygon built only as far as it takes to draw it: its
+ * closed outline of cubics, its center and its bounds. It does not build the
+ * Feature objects of a RoundedPolygonShape, and keeps each cubic once instead
+ * of once in its feature and once in the outline, which suits shapes that
+ * are only ever drawn.
+ *
+ * shape() builds the full RoundedPolygonShape, features included, from the
+ * vertices and roundings kept alongside the outline, with every transform
+ * applied since. PreparedShape does this the first time an outline shape
+ * takes part in a morph.
+ */
+class OutlineShape {
+public:
+    /**
+     * Takes the same arguments as the vertex constructor of
+     * RoundedPolygonShape.
+     */
+    OutlineShape(const std::vector<float>& vertices,
+        const CornerRounding& rounding = CornerRounding::Unrounded,
+        const std::vector<CornerRounding>* perVertexRounding = nullptr,
+        float centerX = std::numeric_limits<float>::lowest(),
+        float centerY = std::numeric_limits<float>::lowest());
+
+    /**
+     * Takes the same arguments as the regular polygon constructor of
+     * RoundedPolygonShape.
+     */
+    OutlineShape(int numVertices, float radius = 1.0f, float centerX = 0.0f,
+        float centerY = 0.0f,
+        const CornerRounding& rounding = CornerRounding::Unrounded,
+        const std::vector<CornerRounding>* perVertexRounding = nullptr);
+
+    [[nodiscard]] float centerX() const { return m_center.x; }
+
+    [[nodiscard]] float centerY() const { return m_center.y; }
+
+    [[nodiscard]] const Point& center() const { return m_center; }
+
+    [[nodiscard]] const std::vector<Cubic>& cubics() const { return m_cubics; }
+
+    // Transform this outline with a point transformer
+    [[nodiscard]] OutlineShape transformed(const PointTransformer& f) const;
+
+    // Normalize the outline to fit within unit square (0,0)-(1,1)
+    [[nodiscard]] OutlineShape normalized() const;
+
+    // Calculate axis-aligned bounding box
+    // bounds[0]=left, bounds[1]=top, bounds[2]=right, bounds[3]=bottom
+    void calculateBounds(
+        std::array<float, 4>& bounds, bool approximate = true) const;
+    [[nodiscard]] std::array<float, 4> calculateBounds(
+        bool approximate = true) const;
+
+    // Calculate max bounds (square that can hold shape in any rotation)
+    void calculateMaxBounds(std::array<float, 4>& bounds) const;
+    [[nodiscard]] std::array<float, 4> calculateMaxBounds() const;
+
+    /**
+     * The full shape with features, as RoundedPolygonShape would have built
+     * it from the same arguments and transforms.
+     */
+    [[nodiscard]] RoundedPolygonShape shape() const;
+
+private:
+    std::vector<Cubic> m_cubics;
+    Point m_center;
+
+    // What shape() builds the full shape from
+    std::vector<float> m_vertices;
+    std::vector<CornerRounding> m_roundings;
+    float m_sourceCenterX;
+    float m_sourceCenterY;
+    PointTransformer m_transform;
+};
+
+} // namespace RoundedPolygon
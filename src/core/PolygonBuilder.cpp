@@ -0,0 +1,188 @@
+#include "PolygonBuilder.hpp"
+#include <cmath>
+#include <stdexcept>
+
+namespace RoundedPolygon {
+
+PolygonBuilder::PolygonBuilder(const std::vector<float>& vertices,
+    const CornerRounding& rounding,
+    const std::vector<CornerRounding>* perVertexRounding, float centerX,
+    float centerY) {
+    if (vertices.size() < 6) {
+        throw std::invalid_argument("Polygons must have at least 3 vertices");
+    }
+    if (vertices.size() % 2 == 1) {
+        throw std::invalid_argument("The vertices array should have even size");
+    }
+    if (perVertexRounding && perVertexRounding->size() * 2 != vertices.size()) {
+        throw std::invalid_argument(
+            "perVertexRounding list should be either null or "
+            "the same size as the number of vertices (vertices.size / 2)");
+    }
+
+    const size_t n = vertices.size() / 2;
+    m_vertices.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        m_vertices.emplace_back(vertices[i * 2], vertices[i * 2 + 1]);
+    }
+    m_roundings = perVertexRounding ? *perVertexRounding
+                                    : std::vector<CornerRounding>(n, rounding);
+
+    constexpr float lowest = std::numeric_limits<float>::lowest();
+    constexpr float epsilon = 1e-30f;
+    if (std::abs(centerX - lowest) >= epsilon &&
+        std::abs(centerY - lowest) >= epsilon) {
+        m_center = Point(centerX, centerY);
+    }
+
+    m_corners.reserve(n);
+    m_convex.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        const Point& prev = m_vertices[wrapped(i, 1)];
+        const Point& next = m_vertices[(i + 1) % n];
+        m_corners.emplace_back(prev, m_vertices[i], next, m_roundings[i]);
+        m_convex.push_back(convex(prev, m_vertices[i], next));
+    }
+    m_cutAdjusts.resize(n);
+    m_cornerCubics.resize(n);
+    m_edges.resize(n);
+
+    // Each stage only reads the results of the previous ones
+    for (size_t i = 0; i < n; ++i) {
+        updateCutAdjust(i);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        updateCornerCubics(i);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        updateEdge(i);
+    }
+}
+
+void PolygonBuilder::setVertex(size_t index, const Point& vertex) {
+    if (index >= size()) {
+        throw std::out_of_range("PolygonBuilder vertex index out of range");
+    }
+    m_vertices[index] = vertex;
+    rebuildAround(index, 1);
+}
+
+void PolygonBuilder::setRounding(size_t index, const CornerRounding& rounding) {
+    if (index >= size()) {
+        throw std::out_of_range("PolygonBuilder vertex index out of range");
+    }
+    m_roundings[index] = rounding;
+    rebuildAround(index, 0);
+}
+
+RoundedPolygonShape PolygonBuilder::shape() const {
+    const size_t n = size();
+    std::vector<std::unique_ptr<Feature>> features;
+    features.reserve(n * 2);
+    for (size_t i = 0; i < n; ++i) {
+        if (m_convex[i]) {
+            features.push_back(Feature::buildConvexCorner(m_cornerCubics[i]));
+        } else {
+            features.push_back(Feature::buildConcaveCorner(m_cornerCubics[i]));
+        }
+        features.push_back(Feature::buildEdge(m_edges[i]));
+    }
+
+    return RoundedPolygonShape(std::move(features), center());
+}
+
+Point PolygonBuilder::center() const {
+    if (m_center) {
+        return *m_center;
+    }
+    float cumulativeX = 0.0f;
+    float cumulativeY = 0.0f;
+    for (const auto& vertex : m_vertices) {
+        cumulativeX += vertex.x;
+        cumulativeY += vertex.y;
+    }
+    float numPoints = static_cast<float>(size());
+    return Point(cumulativeX / numPoints, cumulativeY / numPoints);
+}
+
+void PolygonBuilder::outline(std::vector<Cubic>& cubics) const {
+    // Corners and edges alternate, like the features of shape()
+    RoundedPolygonShape::buildOutline(
+        size() * 2,
+        [this](size_t index) {
+            if (index % 2 == 0) {
+                return std::span<const Cubic>(m_cornerCubics[index / 2]);
+            }
+            return std::span<const Cubic>(&m_edges[index / 2], 1);
+        },
+        center(), cubics);
+}
+
+// Rebuild everything depending on the corners within reach of index, in the
+// same stage order as the constructor
+void PolygonBuilder::rebuildAround(size_t index, size_t reach) {
+    for (size_t i = 0; i <= reach * 2; ++i) {
+        updateCorner(wrapped(index + i, reach));
+    }
+    // Sides after the vertices from index - reach - 1 to index + reach
+    for (size_t i = 0; i <= reach * 2 + 1; ++i) {
+        updateCutAdjust(wrapped(index + i, reach + 1));
+    }
+    for (size_t i = 0; i <= reach * 2 + 2; ++i) {
+        updateCornerCubics(wrapped(index + i, reach + 1));
+    }
+    for (size_t i = 0; i <= reach * 2 + 3; ++i) {
+        updateEdge(wrapped(index + i, reach + 2));
+    }
+}
+
+void PolygonBuilder::updateCorner(size_t index) {
+    const Point& prev = m_vertices[wrapped(index, 1)];
+    const Point& curr = m_vertices[index];
+    const Point& next = m_vertices[(index + 1) % size()];
+    m_corners[index] = RoundedCorner(prev, curr, next, m_roundings[index]);
+    m_convex[index] = convex(prev, curr, next);
+}
+
+void PolygonBuilder::updateCutAdjust(size_t index) {
+    const RoundedCorner& corner = m_corners[index];
+    const RoundedCorner& nextCorner = m_corners[(index + 1) % size()];
+    float expectedRoundCut =
+        corner.expectedRoundCut() + nextCorner.expectedRoundCut();
+    float expectedCut = corner.expectedCut() + nextCorner.expectedCut();
+
+    const Point& vtx = m_vertices[index];
+    const Point& nextVtx = m_vertices[(index + 1) % size()];
+    float sideSize = distance(vtx.x - nextVtx.x, vtx.y - nextVtx.y);
+
+    if (expectedRoundCut > sideSize) {
+        m_cutAdjusts[index] = { sideSize / expectedRoundCut, 0.0f };
+    } else if (expectedCut > sideSize) {
+        m_cutAdjusts[index] = { 1.0f,
+            (sideSize - expectedRoundCut) / (expectedCut - expectedRoundCut) };
+    } else {
+        m_cutAdjusts[index] = { 1.0f, 1.0f };
+    }
+}
+
+void PolygonBuilder::updateCornerCubics(size_t index) {
+    const RoundedCorner& corner = m_corners[index];
+    float allowedCuts[2];
+    for (size_t delta = 0; delta <= 1; ++delta) {
+        auto [roundCutRatio, cutRatio] =
+            m_cutAdjusts[wrapped(index + delta, 1)];
+        allowedCuts[delta] =
+            corner.expectedRoundCut() * roundCutRatio +
+            (corner.expectedCut() - corner.expectedRoundCut()) * cutRatio;
+    }
+    m_cornerCubics[index] = corner.getCubics(allowedCuts[0], allowedCuts[1]);
+}
+
+void PolygonBuilder::updateEdge(size_t index) {
+    const Cubic& end = m_cornerCubics[index].back();
+    const Cubic& start = m_cornerCubics[(index + 1) % size()].front();
+    m_edges[index] = Cubic::straightLine(
+        end.anchor1X(), end.anchor1Y(), start.anchor0X(), start.anchor0Y());
+}
+
+} // namespace RoundedPolygon
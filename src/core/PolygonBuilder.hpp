@@ -0,0 +1,104 @@
+#pragma once
+
+#include "RoundedPolygon.hpp"
+#include <limits>
+#include <vector>
+
+namespace RoundedPolygon {
+
+/**
+ * PolygonBuilder keeps the vertices and per-vertex rounding of a polygon
+ * together with the corners and edges built from them, so that editing one
+ * vertex or one rounding only rebuilds the geometry around it.
+ *
+ * Moving a vertex changes the three corners it is part of, which changes the
+ * cuts of the four sides next to them, the cubics of five corners and the six
+ * edges joining those. Changing a rounding touches one corner less on each
+ * side. Either edit costs the same regardless of the number of vertices.
+ *
+ * shape() assembles a RoundedPolygonShape from the cached cubics. It is the
+ * same shape the vertex constructor of RoundedPolygonShape builds from the
+ * current vertices and roundings.
+ */
+class PolygonBuilder {
+public:
+    /**
+     * Takes the same arguments, and throws for the same invalid input, as the
+     * vertex constructor of RoundedPolygonShape.
+     */
+    PolygonBuilder(const std::vector<float>& vertices,
+        const CornerRounding& rounding = CornerRounding::Unrounded,
+        const std::vector<CornerRounding>* perVertexRounding = nullptr,
+        float centerX = std::numeric_limits<float>::lowest(),
+        float centerY = std::numeric_limits<float>::lowest());
+
+    [[nodiscard]] size_t size() const { return m_vertices.size(); }
+
+    [[nodiscard]] const Point& vertex(size_t index) const {
+        return m_vertices.at(index);
+    }
+
+    [[nodiscard]] const CornerRounding& rounding(size_t index) const {
+        return m_roundings.at(index);
+    }
+
+    /**
+     * Move one vertex. Throws std::out_of_range for an invalid index.
+     */
+    void setVertex(size_t index, const Point& vertex);
+
+    /**
+     * Change the rounding of one vertex. Throws std::out_of_range for an
+     * invalid index.
+     */
+    void setRounding(size_t index, const CornerRounding& rounding);
+
+    /**
+     * Cubics of the corner at the given vertex.
+     */
+    [[nodiscard]] const std::vector<Cubic>& cornerCubics(size_t index) const {
+        return m_cornerCubics.at(index);
+    }
+
+    /**
+     * The polygon for the current vertices and roundings. Unless a center was
+     * given, the center is the average of the vertices.
+     */
+    [[nodiscard]] RoundedPolygonShape shape() const;
+
+    /**
+     * The center of shape().
+     */
+    [[nodiscard]] Point center() const;
+
+    /**
+     * Writes the cubics of shape() into cubics, without building the shape's
+     * features.
+     */
+    void outline(std::vector<Cubic>& cubics) const;
+
+private:
+    std::vector<Point> m_vertices;
+    std::vector<CornerRounding> m_roundings;
+    std::optional<Point> m_center;
+
+    std::vector<RoundedCorner> m_corners;
+    std::vector<bool> m_convex;
+    // Round cut and smoothing cut ratios of the side after each vertex
+    std::vector<std::pair<float, float>> m_cutAdjusts;
+    std::vector<std::vector<Cubic>> m_cornerCubics;
+    // Straight line from each corner to the next one
+    std::vector<Cubic> m_edges;
+
+    [[nodiscard]] size_t wrapped(size_t index, size_t back) const {
+        return (index + size() - back) % size();
+    }
+
+    void rebuildAround(size_t index, size_t reach);
+    void updateCorner(size_t index);
+    void updateCutAdjust(size_t index);
+    void updateCornerCubics(size_t index);
+    void updateEdge(size_t index);
+};
+
+} // namespace RoundedPolygon
@@ -1,7 +1,9 @@
 #include "RoundedPolygon.hpp"
+#include "PolygonBuilder.hpp"
 #include <algorithm>
 #include <cmath>
 #include <limits>
+#include <numbers>
 #include <optional>
 #include <stdexcept>
 
@@ -26,114 +28,11 @@ RoundedPolygonShape::RoundedPolygonShape(int numVertices, float radius,
 RoundedPolygonShape::RoundedPolygonShape(const std::vector<float>& vertices,
     const CornerRounding& rounding,
     const std::vector<CornerRounding>* perVertexRounding, float centerX,
-    float centerY) {
-    if (vertices.size() < 6) {
-        throw std::invalid_argument("Polygons must have at least 3 vertices");
-    }
-    if (vertices.size() % 2 == 1) {
-        throw std::invalid_argument("The vertices array should have even size");
-    }
-    if (perVertexRounding && perVertexRounding->size() * 2 != vertices.size()) {
-        throw std::invalid_argument(
-            "perVertexRounding list should be either null or "
-            "the same size as the number of vertices (vertices.size / 2)");
-    }
-
-    const size_t n = vertices.size() / 2;
-    std::vector<std::vector<Cubic>> corners;
-    std::vector<RoundedCorner> roundedCorners;
-
-    // Create rounded corners
-    for (size_t i = 0; i < n; ++i) {
-        const CornerRounding& vtxRounding =
-            perVertexRounding ? (*perVertexRounding)[i] : rounding;
-        size_t prevIndex = ((i + n - 1) % n) * 2;
-        size_t nextIndex = ((i + 1) % n) * 2;
-
-        roundedCorners.emplace_back(
-            Point(vertices[prevIndex], vertices[prevIndex + 1]),
-            Point(vertices[i * 2], vertices[i * 2 + 1]),
-            Point(vertices[nextIndex], vertices[nextIndex + 1]), vtxRounding);
-    }
-
-    // Calculate cut adjustments
-    std::vector<std::pair<float, float>> cutAdjusts;
-    for (size_t ix = 0; ix < n; ++ix) {
-        float expectedRoundCut =
-            roundedCorners[ix].expectedRoundCut() +
-            roundedCorners[(ix + 1) % n].expectedRoundCut();
-        float expectedCut = roundedCorners[ix].expectedCut() +
-                            roundedCorners[(ix + 1) % n].expectedCut();
-
-        float vtxX = vertices[ix * 2];
-        float vtxY = vertices[ix * 2 + 1];
-        float nextVtxX = vertices[((ix + 1) % n) * 2];
-        float nextVtxY = vertices[((ix + 1) % n) * 2 + 1];
-        float sideSize = distance(vtxX - nextVtxX, vtxY - nextVtxY);
-
-        if (expectedRoundCut > sideSize) {
-            cutAdjusts.emplace_back(sideSize / expectedRoundCut, 0.0f);
-        } else if (expectedCut > sideSize) {
-            cutAdjusts.emplace_back(1.0f, (sideSize - expectedRoundCut) /
-                                              (expectedCut - expectedRoundCut));
-        } else {
-            cutAdjusts.emplace_back(1.0f, 1.0f);
-        }
-    }
-
-    // Create beziers for each rounded corner
-    for (size_t i = 0; i < n; ++i) {
-        std::vector<float> allowedCuts(2);
-        for (size_t delta = 0; delta <= 1; ++delta) {
-            auto [roundCutRatio, cutRatio] =
-                cutAdjusts[(i + n - 1 + delta) % n];
-            allowedCuts[delta] =
-                roundedCorners[i].expectedRoundCut() * roundCutRatio +
-                (roundedCorners[i].expectedCut() -
-                    roundedCorners[i].expectedRoundCut()) *
-                    cutRatio;
-        }
-        corners.push_back(
-            roundedCorners[i].getCubics(allowedCuts[0], allowedCuts[1]));
-    }
-
-    // Build features
-    for (size_t i = 0; i < n; ++i) {
-        size_t prevVtxIndex = (i + n - 1) % n;
-        size_t nextVtxIndex = (i + 1) % n;
-        Point currVertex(vertices[i * 2], vertices[i * 2 + 1]);
-        Point prevVertex(
-            vertices[prevVtxIndex * 2], vertices[prevVtxIndex * 2 + 1]);
-        Point nextVertex(
-            vertices[nextVtxIndex * 2], vertices[nextVtxIndex * 2 + 1]);
-        bool isConvex = convex(prevVertex, currVertex, nextVertex);
-
-        if (isConvex) {
-            m_features.push_back(Feature::buildConvexCorner(corners[i]));
-        } else {
-            m_features.push_back(Feature::buildConcaveCorner(corners[i]));
-        }
-
-        // Add edge
-        std::vector<Cubic> edgeCubics = { Cubic::straightLine(
-            corners[i].back().anchor1X(), corners[i].back().anchor1Y(),
-            corners[(i + 1) % n].front().anchor0X(),
-            corners[(i + 1) % n].front().anchor0Y()) };
-        m_features.push_back(Feature::buildEdge(edgeCubics[0]));
-    }
-
-    // Set center
-    constexpr float lowest = std::numeric_limits<float>::lowest();
-    constexpr float epsilon = 1e-30f;
-    if (std::abs(centerX - lowest) < epsilon ||
-        std::abs(centerY - lowest) < epsilon) {
-        m_center = calculateCenterFromVertices(vertices);
-    } else {
-        m_center = Point(centerX, centerY);
-    }
-
-    buildCubics();
-}
+    float centerY)
+    : RoundedPolygonShape(
+          PolygonBuilder(
+              vertices, rounding, perVertexRounding, centerX, centerY)
+              .shape()) {}
 
 RoundedPolygonShape::RoundedPolygonShape(const RoundedPolygonShape& other)
     : m_center(other.m_center)
@@ -177,7 +76,18 @@ RoundedPolygonShape& RoundedPolygonShape::operator=(
 }
 
 void RoundedPolygonShape::buildCubics() {
-    m_cubics.clear();
+    buildOutline(
+        m_features.size(),
+        [this](size_t index) {
+            return std::span<const Cubic>(m_features[index]->cubics());
+        },
+        m_center, m_cubics);
+}
+
+void RoundedPolygonShape::buildOutline(size_t featureCount,
+    const std::function<std::span<const Cubic>(size_t)>& featureCubics,
+    const Point& center, std::vector<Cubic>& cubics) {
+    cubics.clear();
 
     // Track first and last non-zero cubics (stored by value, not pointer)
     std::optional<Cubic> firstCubic;
@@ -186,32 +96,35 @@ void RoundedPolygonShape::buildCubics() {
     std::vector<Cubic> firstFeatureSplitStart;
     std::vector<Cubic> firstFeatureSplitEnd;
 
-    if (!m_features.empty() && m_features[0]->cubics().size() == 3) {
-        const Cubic& centerCubic = m_features[0]->cubics()[1];
-        auto [start, end] = centerCubic.split(0.5f);
-        firstFeatureSplitStart = { m_features[0]->cubics()[0], start };
-        firstFeatureSplitEnd = { end, m_features[0]->cubics()[2] };
+    std::span<const Cubic> first;
+    if (featureCount > 0) {
+        first = featureCubics(0);
+    }
+    if (first.size() == 3) {
+        auto [start, end] = first[1].split(0.5f);
+        firstFeatureSplitStart = { first[0], start };
+        firstFeatureSplitEnd = { end, first[2] };
     }
 
-    for (size_t i = 0; i <= m_features.size(); ++i) {
-        const std::vector<Cubic>* featureCubics = nullptr;
+    for (size_t i = 0; i <= featureCount; ++i) {
+        std::span<const Cubic> currentCubics;
 
         if (i == 0 && !firstFeatureSplitEnd.empty()) {
-            featureCubics = &firstFeatureSplitEnd;
-        } else if (i == m_features.size()) {
+            currentCubics = firstFeatureSplitEnd;
+        } else if (i == featureCount) {
             if (!firstFeatureSplitStart.empty()) {
-                featureCubics = &firstFeatureSplitStart;
+                currentCubics = firstFeatureSplitStart;
             } else {
                 break;
             }
         } else {
-            featureCubics = &m_features[i]->cubics();
+            currentCubics = featureCubics(i);
         }
 
-        for (const auto& cubic : *featureCubics) {
+        for (const auto& cubic : currentCubics) {
             if (!cubic.zeroLength()) {
                 if (lastCubic) {
-                    m_cubics.push_back(*lastCubic);
+                    cubics.push_back(*lastCubic);
                 }
                 lastCubic = cubic;
                 if (!firstCubic) {
@@ -227,13 +140,13 @@ void RoundedPolygonShape::buildCubics() {
 
     if (lastCubic && firstCubic) {
         // Add final cubic that closes the shape by connecting back to first
-        m_cubics.push_back(Cubic(lastCubic->anchor0X(), lastCubic->anchor0Y(),
+        cubics.push_back(Cubic(lastCubic->anchor0X(), lastCubic->anchor0Y(),
             lastCubic->control0X(), lastCubic->control0Y(),
             lastCubic->control1X(), lastCubic->control1Y(),
             firstCubic->anchor0X(), firstCubic->anchor0Y()));
     } else {
         // Empty / 0-sized polygon
-        m_cubics.push_back(Cubic::empty(m_center.x, m_center.y));
+        cubics.push_back(Cubic::empty(center.x, center.y));
     }
 }
 
@@ -261,6 +174,78 @@ RoundedPolygonShape RoundedPolygonShape::normalized() const {
     });
 }
 
+RoundedPolygonShape RoundedPolygonShape::simplified(float maxError) const {
+    std::vector<std::unique_ptr<Feature>> features;
+
+    // Cubics waiting to be merged into a single edge, and a sharp corner at
+    // the end of that run which is dropped if the run continues past it
+    std::vector<Cubic> run;
+    std::unique_ptr<Feature> pendingCorner;
+
+    auto flushRun = [&features, &run]() {
+        if (run.size() == 1) {
+            features.push_back(Feature::buildEdge(run.front()));
+        } else if (!run.empty()) {
+            features.push_back(Feature::buildEdge(Cubic::merged(run)));
+        }
+        run.clear();
+    };
+
+    auto flushCorner = [&features, &pendingCorner]() {
+        if (pendingCorner) {
+            features.push_back(std::move(pendingCorner));
+        }
+    };
+
+    auto identity = [](float x, float y) { return TransformResult(x, y); };
+
+    for (const auto& feature : m_features) {
+        const auto& cubics = feature->cubics();
+        bool sharp = std::all_of(cubics.begin(), cubics.end(),
+            [](const Cubic& cubic) { return cubic.zeroLength(); });
+
+        if (feature->isEdge() || sharp) {
+            if (!feature->isEdge()) {
+                if (pendingCorner) {
+                    flushRun();
+                    flushCorner();
+                }
+                pendingCorner = feature->transformed(identity);
+                continue;
+            }
+            for (const auto& cubic : cubics) {
+                if (cubic.zeroLength()) {
+                    continue;
+                }
+                if (!run.empty()) {
+                    run.push_back(cubic);
+                    Cubic candidate = Cubic::merged(run);
+                    if (Cubic::deviation(run, candidate) <= maxError) {
+                        // The outline is flat enough here that the corner
+                        // between the previous cubics and this one is not a
+                        // feature worth keeping
+                        pendingCorner.reset();
+                        continue;
+                    }
+                    run.pop_back();
+                    flushRun();
+                }
+                flushCorner();
+                run.push_back(cubic);
+            }
+        } else {
+            // Rounded corners are kept intact
+            flushRun();
+            flushCorner();
+            features.push_back(feature->transformed(identity));
+        }
+    }
+    flushRun();
+    flushCorner();
+
+    return RoundedPolygonShape(std::move(features), m_center);
+}
+
 void RoundedPolygonShape::calculateBounds(
     std::array<float, 4>& bounds, bool approximate) const {
     float minX = std::numeric_limits<float>::max();
@@ -316,27 +301,18 @@ std::array<float, 4> RoundedPolygonShape::calculateMaxBounds() const {
     return bounds;
 }
 
-Point RoundedPolygonShape::calculateCenterFromVertices(
-    const std::vector<float>& vertices) {
-    float cumulativeX = 0.0f;
-    float cumulativeY = 0.0f;
-    for (size_t i = 0; i < vertices.size(); i += 2) {
-        cumulativeX += vertices[i];
-        cumulativeY += vertices[i + 1];
-    }
-    float numPoints = static_cast<float>(vertices.size()) / 2.0f;
-    return Point(cumulativeX / numPoints, cumulativeY / numPoints);
-}
-
 std::vector<float> RoundedPolygonShape::verticesFromNumVerts(
     int numVertices, float radius, float centerX, float centerY) {
-    std::vector<float> result(static_cast<size_t>(numVertices) * 2);
-    for (size_t i = 0; i < static_cast<size_t>(numVertices); ++i) {
-        Point vertex = radialToCartesian(
-            radius, FloatPi / static_cast<float>(numVertices) * 2.0f *
-                        static_cast<float>(i));
-        result[i * 2] = vertex.x + centerX;
-        result[i * 2 + 1] = vertex.y + centerY;
+    const size_t count = static_cast<size_t>(numVertices);
+    std::vector<float> cosines(count);
+    std::vector<float> sines(count);
+    unitCircle(count, 0.0, 2.0 * std::numbers::pi / static_cast<double>(count),
+        cosines.data(), sines.data());
+
+    std::vector<float> result(count * 2);
+    for (size_t i = 0; i < count; ++i) {
+        result[i * 2] = cosines[i] * radius + centerX;
+        result[i * 2 + 1] = sines[i] * radius + centerY;
     }
     return result;
 }
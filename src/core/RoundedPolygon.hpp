@@ -2,8 +2,10 @@
 
 #include "CornerRounding.hpp"
 #include "Feature.hpp"
+#include <functional>
 #include <memory>
 #include <optional>
+#include <span>
 #include <vector>
 
 namespace RoundedPolygon {
@@ -67,6 +69,12 @@ public:
     // Normalize polygon to fit within unit square (0,0)-(1,1)
     [[nodiscard]] RoundedPolygonShape normalized() const;
 
+    // Merge runs of consecutive cubics that stay within maxError of a single
+    // cubic. Rounded corners are kept as they are, and sharp corners are only
+    // merged away when the outline is flat enough there to stay within
+    // maxError, so the corners used for morph mapping are preserved.
+    [[nodiscard]] RoundedPolygonShape simplified(float maxError) const;
+
     // Calculate axis-aligned bounding box
     // bounds[0]=left, bounds[1]=top, bounds[2]=right, bounds[3]=bottom
     void calculateBounds(
@@ -78,16 +86,23 @@ public:
     void calculateMaxBounds(std::array<float, 4>& bounds) const;
     [[nodiscard]] std::array<float, 4> calculateMaxBounds() const;
 
+    // Build the closed outline through the cubics of featureCount features,
+    // given in order by featureCubics, into cubics. Zero-length cubics are
+    // dropped and the outline starts in the middle of the first feature.
+    static void buildOutline(size_t featureCount,
+        const std::function<std::span<const Cubic>(size_t)>& featureCubics,
+        const Point& center, std::vector<Cubic>& cubics);
+
+    // Vertices of the regular polygon built by the numVertices constructor
+    static std::vector<float> verticesFromNumVerts(
+        int numVertices, float radius, float centerX, float centerY);
+
 private:
     std::vector<std::unique_ptr<Feature>> m_features;
     Point m_center;
     std::vector<Cubic> m_cubics;
 
     void buildCubics();
-    static Point calculateCenterFromVertices(
-        const std::vector<float>& vertices);
-    static std::vector<float> verticesFromNumVerts(
-        int numVertices, float radius, float centerX, float centerY);
 };
 
 // Helper class for corner rounding calculations
@@ -55,6 +55,26 @@ constexpr float RelaxedDistanceEpsilon = 5e-3f;
     return directionVector(angleRadians) * radius + center;
 }
 
+// Cosines and sines of the count angles startAngle + i * step, written into
+// separate arrays so callers can run plain loops over them. Only the first
+// angle and the step go through std::cos/std::sin; every other angle is the
+// previous one rotated by step, in double precision so that the recurrence
+// stays within float rounding of the direct results.
+inline void unitCircle(size_t count, double startAngle, double step,
+    float* cosines, float* sines) {
+    const double stepCos = std::cos(step);
+    const double stepSin = std::sin(step);
+    double c = std::cos(startAngle);
+    double s = std::sin(startAngle);
+    for (size_t i = 0; i < count; ++i) {
+        cosines[i] = static_cast<float>(c);
+        sines[i] = static_cast<float>(s);
+        const double next = c * stepCos - s * stepSin;
+        s = s * stepCos + c * stepSin;
+        c = next;
+    }
+}
+
 // Positive modulo (result is always positive)
 [[nodiscard]] inline float positiveModulo(float num, float mod) {
     float result = std::fmod(num, mod);
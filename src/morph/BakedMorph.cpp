@@ -0,0 +1,105 @@
+#include "BakedMorph.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace RoundedPolygon {
+
+BakedMorph::BakedMorph(const Morph& morph, size_t frameCount,
+    const Easing& easing, bool deltaEncoded)
+    : m_frameCount(frameCount) {
+    if (frameCount < 2) {
+        throw std::invalid_argument("BakedMorph needs at least 2 frames");
+    }
+
+    const float lastFrame = static_cast<float>(frameCount - 1);
+    std::vector<Cubic> frames;
+    for (size_t i = 0; i < frameCount; ++i) {
+        float fraction = static_cast<float>(i) / lastFrame;
+        float progress = easing ? easing(fraction) : fraction;
+        auto cubics = morph.asCubics(progress);
+        if (i == 0) {
+            m_cubicCount = cubics.size();
+            frames.reserve(m_cubicCount * frameCount);
+        }
+        frames.insert(frames.end(), cubics.begin(), cubics.end());
+    }
+
+    if (!deltaEncoded || m_cubicCount == 0) {
+        m_frames = std::move(frames);
+        return;
+    }
+
+    // Quantize every frame against the first one, using a single scale so
+    // the error bound holds for the whole timeline
+    float maxDelta = 0.0f;
+    for (size_t i = m_cubicCount; i < frames.size(); ++i) {
+        const auto& points = frames[i].points();
+        const auto& base = frames[i % m_cubicCount].points();
+        for (size_t j = 0; j < 8; ++j) {
+            maxDelta = std::max(maxDelta, std::abs(points[j] - base[j]));
+        }
+    }
+
+    constexpr float range =
+        static_cast<float>(std::numeric_limits<int16_t>::max());
+    m_deltaScale = maxDelta / range;
+    m_deltas.reserve((frames.size() - m_cubicCount) * 8);
+    for (size_t i = m_cubicCount; i < frames.size(); ++i) {
+        const auto& points = frames[i].points();
+        const auto& base = frames[i % m_cubicCount].points();
+        for (size_t j = 0; j < 8; ++j) {
+            float delta = m_deltaScale > 0.0f
+                              ? (points[j] - base[j]) / m_deltaScale
+                              : 0.0f;
+            m_deltas.push_back(static_cast<int16_t>(std::lround(delta)));
+        }
+    }
+
+    frames.resize(m_cubicCount);
+    m_frames = std::move(frames);
+}
+
+size_t BakedMorph::frameIndex(float fraction) const {
+    float clamped = std::clamp(fraction, 0.0f, 1.0f);
+    return static_cast<size_t>(
+        std::lround(clamped * static_cast<float>(m_frameCount - 1)));
+}
+
+void BakedMorph::frame(size_t index, std::vector<Cubic>& cubics) const {
+    if (index >= m_frameCount) {
+        throw std::out_of_range("BakedMorph frame index out of range");
+    }
+
+    if (!deltaEncoded() || index == 0) {
+        auto begin = m_frames.begin() +
+                     static_cast<std::ptrdiff_t>(index * m_cubicCount);
+        cubics.assign(
+            begin, begin + static_cast<std::ptrdiff_t>(m_cubicCount));
+        return;
+    }
+
+    cubics.resize(m_cubicCount);
+    const int16_t* deltas = m_deltas.data() + (index - 1) * m_cubicCount * 8;
+    for (size_t i = 0; i < m_cubicCount; ++i) {
+        const auto& base = m_frames[i].points();
+        auto& points = cubics[i].points();
+        for (size_t j = 0; j < 8; ++j) {
+            points[j] = base[j] + static_cast<float>(deltas[i * 8 + j]) *
+                                      m_deltaScale;
+        }
+    }
+}
+
+std::vector<Cubic> BakedMorph::frame(size_t index) const {
+    std::vector<Cubic> cubics;
+    frame(index, cubics);
+    return cubics;
+}
+
+size_t BakedMorph::byteSize() const {
+    return m_frames.size() * sizeof(Cubic) + m_deltas.size() * sizeof(int16_t);
+}
+
+} // namespace RoundedPolygon
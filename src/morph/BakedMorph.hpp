@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Morph.hpp"
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace RoundedPolygon {
+
+/**
+ * BakedMorph samples a Morph at a fixed number of evenly spaced timeline
+ * positions, so that playing the morph back becomes a frame lookup instead of
+ * an interpolation.
+ *
+ * An optional easing function maps each timeline position to the morph
+ * progress that gets sampled, which bakes overshooting curves into the
+ * frames. Frames are stored either as plain cubics or, when delta encoding is
+ * enabled, as 16-bit offsets from the first frame. Delta encoding halves the
+ * memory used by frames at the cost of a small, bounded quantization error
+ * (see maxError()).
+ */
+class BakedMorph {
+public:
+    /**
+     * Maps a timeline fraction in [0, 1] to a morph progress value.
+     */
+    using Easing = std::function<float(float)>;
+
+    /**
+     * Bake a morph.
+     *
+     * @param morph The morph to sample.
+     * @param frameCount Number of frames to bake (at least 2). Frame 0 is the
+     *        start of the timeline and the last frame is its end.
+     * @param easing Optional easing applied to each timeline position.
+     * @param deltaEncoded Store frames as 16-bit deltas from the first frame.
+     */
+    BakedMorph(const Morph& morph, size_t frameCount,
+        const Easing& easing = nullptr, bool deltaEncoded = false);
+
+    [[nodiscard]] size_t frameCount() const { return m_frameCount; }
+
+    [[nodiscard]] size_t cubicCount() const { return m_cubicCount; }
+
+    [[nodiscard]] bool deltaEncoded() const { return !m_deltas.empty(); }
+
+    /**
+     * Returns the frame nearest to the given timeline fraction. Fractions
+     * outside of [0, 1] are clamped.
+     */
+    [[nodiscard]] size_t frameIndex(float fraction) const;
+
+    /**
+     * Writes the cubics of the given frame into cubics, reusing its storage.
+     */
+    void frame(size_t index, std::vector<Cubic>& cubics) const;
+    [[nodiscard]] std::vector<Cubic> frame(size_t index) const;
+
+    /**
+     * Bound of the per-coordinate error introduced by delta encoding, up to
+     * float rounding. Zero when frames are stored unencoded.
+     */
+    [[nodiscard]] float maxError() const { return m_deltaScale / 2.0f; }
+
+    /**
+     * Approximate number of bytes used by the baked frames.
+     */
+    [[nodiscard]] size_t byteSize() const;
+
+private:
+    size_t m_frameCount;
+    size_t m_cubicCount = 0;
+    // All frames when unencoded, only the first frame when delta encoded
+    std::vector<Cubic> m_frames;
+    // Offsets of frames 1..n-1 from the first frame, 8 per cubic
+    std::vector<int16_t> m_deltas;
+    float m_deltaScale = 0.0f;
+};
+
+} // namespace RoundedPolygon
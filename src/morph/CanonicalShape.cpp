@@ -0,0 +1,222 @@
+#include "CanonicalShape.hpp"
+#include "../core/Utils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <span>
+#include <stdexcept>
+
+namespace RoundedPolygon {
+
+namespace {
+
+// Outline progress of the corner used as the start of the canonical outline:
+// the convex corner (or any corner, if there are no convex ones) whose middle
+// points closest to straight up, in y-down coordinates
+float anchorProgress(const std::vector<const ProgressableFeature*>& corners,
+    const Point& center) {
+    constexpr float up = -FloatPi / 2.0f;
+    for (bool convexOnly : { true, false }) {
+        const ProgressableFeature* best = nullptr;
+        float bestDistance = std::numeric_limits<float>::max();
+        for (const auto* corner : corners) {
+            if (convexOnly && !corner->feature->isConvexCorner()) {
+                continue;
+            }
+            const auto& cubics = corner->feature->cubics();
+            float x = (cubics.front().anchor0X() + cubics.back().anchor1X()) /
+                      2.0f;
+            float y = (cubics.front().anchor0Y() + cubics.back().anchor1Y()) /
+                      2.0f;
+            float angle = std::atan2(y - center.y, x - center.x);
+            float distance = std::abs(
+                positiveModulo(angle - up + FloatPi, TwoPi) - FloatPi);
+            if (distance < bestDistance - AngleEpsilon) {
+                best = corner;
+                bestDistance = distance;
+            }
+        }
+        if (best != nullptr) {
+            return best->progress;
+        }
+    }
+    return 0.0f;
+}
+
+float progressLength(const MeasuredCubic& cubic) {
+    return cubic.endOutlineProgress() - cubic.startOutlineProgress();
+}
+
+// Split each cubic into pieces of equal outline progress, giving every cubic
+// one piece plus a share of the extra pieces proportional to its length.
+// Cubics of no length are padded with empty cubics instead of being cut.
+void splitInto(std::span<const MeasuredCubic> cubics, size_t count,
+    const Measurer& measurer, std::vector<Cubic>& result) {
+    const size_t extra = count - cubics.size();
+    float total = 0.0f;
+    for (const auto& cubic : cubics) {
+        total += progressLength(cubic);
+    }
+
+    std::vector<size_t> pieces(cubics.size(), 1);
+    std::vector<std::pair<float, size_t>> remainders;
+    size_t assigned = 0;
+    for (size_t i = 0; i < cubics.size() && total > AngleEpsilon; ++i) {
+        float share =
+            static_cast<float>(extra) * progressLength(cubics[i]) / total;
+        float whole = std::floor(share);
+        pieces[i] += static_cast<size_t>(whole);
+        assigned += static_cast<size_t>(whole);
+        if (progressLength(cubics[i]) > AngleEpsilon) {
+            remainders.emplace_back(share - whole, i);
+        }
+    }
+    std::stable_sort(remainders.begin(), remainders.end(),
+        [](const auto& a, const auto& b) { return a.first > b.first; });
+    for (size_t i = 0; assigned < extra && !remainders.empty(); ++i) {
+        ++pieces[remainders[i % remainders.size()].second];
+        ++assigned;
+    }
+    pieces.back() += extra - assigned;
+
+    for (size_t i = 0; i < cubics.size(); ++i) {
+        MeasuredCubic remaining = cubics[i];
+        const float start = cubics[i].startOutlineProgress();
+        const float step =
+            progressLength(cubics[i]) / static_cast<float>(pieces[i]);
+        for (size_t k = 1; k < pieces[i]; ++k) {
+            if (step <= AngleEpsilon) {
+                result.push_back(Cubic::empty(remaining.cubic().anchor0X(),
+                    remaining.cubic().anchor0Y()));
+                continue;
+            }
+            auto [piece, rest] = remaining.cutAtProgress(
+                start + step * static_cast<float>(k), measurer);
+            result.push_back(piece.cubic());
+            remaining = rest;
+        }
+        result.push_back(remaining.cubic());
+    }
+}
+
+// Merge the shortest neighbouring runs of cubics until count runs are left
+void mergeInto(std::span<const MeasuredCubic> cubics, size_t count,
+    std::vector<Cubic>& result) {
+    std::vector<std::vector<Cubic>> runs;
+    std::vector<float> lengths;
+    runs.reserve(cubics.size());
+    lengths.reserve(cubics.size());
+    for (const auto& cubic : cubics) {
+        runs.push_back({ cubic.cubic() });
+        lengths.push_back(progressLength(cubic));
+    }
+
+    while (runs.size() > count) {
+        size_t shortest = 0;
+        for (size_t i = 1; i + 1 < runs.size(); ++i) {
+            if (lengths[i] + lengths[i + 1] <
+                lengths[shortest] + lengths[shortest + 1]) {
+                shortest = i;
+            }
+        }
+        auto& run = runs[shortest];
+        auto& next = runs[shortest + 1];
+        run.insert(run.end(), next.begin(), next.end());
+        lengths[shortest] += lengths[shortest + 1];
+        runs.erase(runs.begin() + static_cast<std::ptrdiff_t>(shortest + 1));
+        lengths.erase(
+            lengths.begin() + static_cast<std::ptrdiff_t>(shortest + 1));
+    }
+
+    for (const auto& run : runs) {
+        result.push_back(run.size() == 1 ? run.front() : Cubic::merged(run));
+    }
+}
+
+// Resample cubics into exactly count cubics
+void resampleInto(std::span<const MeasuredCubic> cubics, size_t count,
+    const Measurer& measurer, std::vector<Cubic>& result) {
+    if (cubics.size() <= count) {
+        splitInto(cubics, count, measurer, result);
+    } else {
+        mergeInto(cubics, count, result);
+    }
+}
+
+// Index of the first cubic of each feature along the shifted outline, plus
+// the cubic count at the end. The anchor corner is cut in two, so it counts
+// as one feature at the start and another at the end.
+std::vector<size_t> featureStarts(const std::vector<MeasuredCubic>& cubics,
+    const RoundedPolygonShape& shape) {
+    // Feature of each cubic of the shape, in the numbering of CubicSpan
+    std::vector<size_t> featureOf;
+    for (size_t i = 0; i < shape.features().size(); ++i) {
+        featureOf.insert(
+            featureOf.end(), shape.features()[i]->cubics().size(), i);
+    }
+
+    std::vector<size_t> starts;
+    for (size_t i = 0; i < cubics.size(); ++i) {
+        if (i == 0 || featureOf.at(cubics[i].span().cubic) !=
+                          featureOf.at(cubics[i - 1].span().cubic)) {
+            starts.push_back(i);
+        }
+    }
+    starts.push_back(cubics.size());
+    return starts;
+}
+
+// First canonical cubic of each feature, given the index of the first cubic
+// of each feature. Each feature starts on the cubic its outline progress
+// falls on, so features at the same place along the outline of two shapes
+// get the same cubics, moved only as much as needed to give every feature
+// at least one cubic.
+std::vector<size_t> featureSlots(const std::vector<MeasuredCubic>& cubics,
+    const std::vector<size_t>& starts, size_t count) {
+    const size_t features = starts.size() - 1;
+    std::vector<size_t> slots(starts.size());
+    for (size_t r = 1; r < features; ++r) {
+        const float progress = cubics[starts[r]].startOutlineProgress();
+        slots[r] = std::max(slots[r - 1] + 1,
+            static_cast<size_t>(
+                std::lround(progress * static_cast<float>(count))));
+    }
+    slots[features] = count;
+    for (size_t r = features - 1; r > 0; --r) {
+        slots[r] = std::min(slots[r], slots[r + 1] - 1);
+    }
+    return slots;
+}
+
+} // anonymous namespace
+
+CanonicalShape::CanonicalShape(const MeasuredPolygon& measured,
+    const std::vector<const ProgressableFeature*>& corners,
+    const RoundedPolygonShape& shape, const Measurer& measurer,
+    size_t cubicCount) {
+    if (cubicCount == 0) {
+        throw std::invalid_argument("CanonicalShape needs at least 1 cubic");
+    }
+
+    MeasuredPolygon shifted =
+        measured.cutAndShift(anchorProgress(corners, shape.center()));
+    const std::span<const MeasuredCubic> cubics = shifted.cubics();
+
+    m_cubics.reserve(cubicCount);
+    const std::vector<size_t> starts = featureStarts(shifted.cubics(), shape);
+    if (starts.size() - 1 > cubicCount) {
+        // Too few cubics for one per feature, so features get merged
+        resampleInto(cubics, cubicCount, measurer, m_cubics);
+        return;
+    }
+
+    // Features are resampled separately, so no cubic spans two features
+    const std::vector<size_t> slots =
+        featureSlots(shifted.cubics(), starts, cubicCount);
+    for (size_t r = 0; r + 1 < starts.size(); ++r) {
+        resampleInto(cubics.subspan(starts[r], starts[r + 1] - starts[r]),
+            slots[r + 1] - slots[r], measurer, m_cubics);
+    }
+}
+
+} // namespace RoundedPolygon
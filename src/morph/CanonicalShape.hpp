@@ -0,0 +1,50 @@
+#pragma once
+
+#include "../core/Cubic.hpp"
+#include "PolygonMeasure.hpp"
+#include <vector>
+
+namespace RoundedPolygon {
+
+/**
+ * CanonicalShape is a shape resampled into a fixed number of cubics, so that
+ * any two canonical shapes with the same cubic count can be morphed by pairing
+ * their cubics by index, without feature mapping or cutting.
+ *
+ * The outline starts at the convex corner pointing closest to straight up
+ * from the shape's center, which keeps similar shapes in the same rotation.
+ * Each feature is then given the cubics its stretch of the outline covers, so
+ * a feature starts on the cubic its outline progress falls on and features
+ * at the same place along two outlines get the same cubics. Features are
+ * resampled separately, so no cubic spans two features: a feature given
+ * more cubics than it has splits its cubics in proportion to their length,
+ * which keeps them exact, and one given fewer merges its shortest
+ * neighbouring cubics. Only shapes with more features than the canonical
+ * form has cubics get features merged into each other.
+ *
+ * Features are placed by where they lie, not matched to each other, so
+ * shapes whose corners lie at different places along their outlines, such
+ * as a square and a pentagon, still move corners across edges.
+ */
+class CanonicalShape {
+public:
+    static constexpr size_t DefaultCubicCount = 64;
+
+    /**
+     * Resample a measured shape into cubicCount cubics (at least 1). shape
+     * is the shape measured, whose features place the canonical cubics.
+     */
+    CanonicalShape(const MeasuredPolygon& measured,
+        const std::vector<const ProgressableFeature*>& corners,
+        const RoundedPolygonShape& shape, const Measurer& measurer,
+        size_t cubicCount);
+
+    [[nodiscard]] const std::vector<Cubic>& cubics() const { return m_cubics; }
+
+    [[nodiscard]] size_t cubicCount() const { return m_cubics.size(); }
+
+private:
+    std::vector<Cubic> m_cubics;
+};
+
+} // namespace RoundedPolygon
@@ -1,30 +1,26 @@
 #include "FeatureMapping.hpp"
 #include <algorithm>
+#include <cmath>
 #include <limits>
-#include <set>
 
 namespace RoundedPolygon {
 
 namespace {
 
-struct DistanceVertex {
-    float distance;
-    const ProgressableFeature* f1;
-    const ProgressableFeature* f2;
-
-    bool operator<(const DistanceVertex& other) const {
-        return distance < other.distance;
-    }
-};
-
 class MappingHelper {
 public:
-    std::vector<std::pair<float, float>> mapping;
+    MappingHelper(std::vector<std::pair<float, float>>& result,
+        std::vector<bool>& usedF1, std::vector<bool>& usedF2)
+        : mapping(result)
+        , m_usedF1(usedF1)
+        , m_usedF2(usedF2) {}
 
-    void addMapping(
-        const ProgressableFeature* f1, const ProgressableFeature* f2) {
+    std::vector<std::pair<float, float>>& mapping;
+
+    void addMapping(const ProgressableFeature* f1, size_t index1,
+        const ProgressableFeature* f2, size_t index2) {
         // Don't map the same feature twice
-        if (m_usedF1.count(f1) > 0 || m_usedF2.count(f2) > 0) {
+        if (m_usedF1[index1] || m_usedF2[index2]) {
             return;
         }
 
@@ -63,54 +59,15 @@ public:
 
         // Add the mapping
         mapping.insert(it, { f1->progress, f2->progress });
-        m_usedF1.insert(f1);
-        m_usedF2.insert(f2);
+        m_usedF1[index1] = true;
+        m_usedF2[index2] = true;
     }
 
 private:
-    std::set<const ProgressableFeature*> m_usedF1;
-    std::set<const ProgressableFeature*> m_usedF2;
+    std::vector<bool>& m_usedF1;
+    std::vector<bool>& m_usedF2;
 };
 
-std::vector<std::pair<float, float>> doMapping(
-    const std::vector<const ProgressableFeature*>& features1,
-    const std::vector<const ProgressableFeature*>& features2) {
-
-    // Build distance list for all feature pairs
-    std::vector<DistanceVertex> distanceVertexList;
-    for (const auto* f1 : features1) {
-        for (const auto* f2 : features2) {
-            float d = featureDistSquared(f1->feature, f2->feature);
-            if (d < std::numeric_limits<float>::max()) {
-                distanceVertexList.push_back({ d, f1, f2 });
-            }
-        }
-    }
-
-    // Sort by distance
-    std::sort(distanceVertexList.begin(), distanceVertexList.end());
-
-    // Special cases
-    if (distanceVertexList.empty()) {
-        return { { 0.0f, 0.0f }, { 0.5f, 0.5f } };
-    }
-
-    if (distanceVertexList.size() == 1) {
-        float f1 = distanceVertexList[0].f1->progress;
-        float f2 = distanceVertexList[0].f2->progress;
-        return { { f1, f2 },
-            { std::fmod(f1 + 0.5f, 1.0f), std::fmod(f2 + 0.5f, 1.0f) } };
-    }
-
-    // Build mapping using greedy algorithm
-    MappingHelper helper;
-    for (const auto& vertex : distanceVertexList) {
-        helper.addMapping(vertex.f1, vertex.f2);
-    }
-
-    return helper.mapping;
-}
-
 } // anonymous namespace
 
 DoubleMapper featureMapper(const std::vector<ProgressableFeature>& features1,
@@ -130,10 +87,159 @@ DoubleMapper featureMapper(const std::vector<ProgressableFeature>& features1,
         }
     }
 
-    auto featureProgressMapping =
-        doMapping(filteredFeatures1, filteredFeatures2);
+    return featureMapper(filteredFeatures1, filteredFeatures2);
+}
 
-    return DoubleMapper(featureProgressMapping);
+DoubleMapper featureMapper(
+    const std::vector<const ProgressableFeature*>& corners1,
+    const std::vector<const ProgressableFeature*>& corners2) {
+    IncrementalFeatureMapper mapper;
+    mapper.reset(corners1, corners2);
+    mapper.advance(std::numeric_limits<size_t>::max());
+    return mapper.mapper();
+}
+
+void IncrementalFeatureMapper::reset(
+    const std::vector<const ProgressableFeature*>& corners1,
+    const std::vector<const ProgressableFeature*>& corners2) {
+    m_corners1 = &corners1;
+    m_corners2 = &corners2;
+    m_candidates.clear();
+    m_mapping.clear();
+    // Reserved up front, since growing would copy every candidate so far in
+    // one step
+    m_candidates.reserve(corners1.size() * corners2.size());
+    m_index1 = 0;
+    m_index2 = 0;
+    m_stage = Stage::Measure;
+}
+
+bool IncrementalFeatureMapper::advance(size_t work) {
+    while (work > 0 && !done()) {
+        switch (m_stage) {
+        case Stage::Measure:
+            measure(work);
+            break;
+        case Stage::Sort:
+            sort(work);
+            break;
+        case Stage::Try:
+            tryCandidates(work);
+            break;
+        case Stage::Done:
+            break;
+        }
+    }
+    return done();
+}
+
+void IncrementalFeatureMapper::measure(size_t& work) {
+    // Build distance list for all feature pairs
+    const auto& corners1 = *m_corners1;
+    const auto& corners2 = *m_corners2;
+    while (work > 0 && m_index1 < corners1.size()) {
+        if (m_index2 == corners2.size()) {
+            m_index2 = 0;
+            ++m_index1;
+            continue;
+        }
+        float d = featureDistSquared(
+            corners1[m_index1]->feature, corners2[m_index2]->feature);
+        if (d < std::numeric_limits<float>::max()) {
+            m_candidates.push_back({ d, m_index1, m_index2 });
+        }
+        ++m_index2;
+        --work;
+    }
+    if (m_index1 == corners1.size()) {
+        startSort();
+    }
+}
+
+void IncrementalFeatureMapper::startSort() {
+    m_merged.clear();
+    m_merged.reserve(m_candidates.size());
+    m_width = 1;
+    m_low = 0;
+    m_left = 0;
+    m_right = std::min<size_t>(1, m_candidates.size());
+    m_stage = Stage::Sort;
+}
+
+void IncrementalFeatureMapper::sort(size_t& work) {
+    // Sort by distance, merging runs of doubling width. Taking the left run
+    // on ties keeps the sort stable, so equally distant candidates are tried
+    // in the order they were measured.
+    const size_t n = m_candidates.size();
+    while (work > 0 && m_width < n) {
+        const size_t middle = std::min(m_low + m_width, n);
+        const size_t high = std::min(m_low + 2 * m_width, n);
+        // Runs are merged in order, so each pass fills m_merged from the
+        // front
+        while (work > 0 && (m_left < middle || m_right < high)) {
+            if (m_right == high ||
+                (m_left < middle &&
+                    !(m_candidates[m_right].distance <
+                        m_candidates[m_left].distance))) {
+                m_merged.push_back(m_candidates[m_left++]);
+            } else {
+                m_merged.push_back(m_candidates[m_right++]);
+            }
+            --work;
+        }
+        if (m_left == middle && m_right == high) {
+            m_low = high;
+            if (m_low == n) {
+                m_candidates.swap(m_merged);
+                m_merged.clear();
+                m_width *= 2;
+                m_low = 0;
+            }
+            m_left = m_low;
+            m_right = std::min(m_low + m_width, n);
+        }
+    }
+    if (m_width >= n) {
+        startTrying();
+    }
+}
+
+void IncrementalFeatureMapper::startTrying() {
+    const auto& corners1 = *m_corners1;
+    const auto& corners2 = *m_corners2;
+    m_stage = Stage::Done;
+
+    // Special cases
+    if (m_candidates.empty()) {
+        m_mapping.assign({ { 0.0f, 0.0f }, { 0.5f, 0.5f } });
+        return;
+    }
+
+    if (m_candidates.size() == 1) {
+        float f1 = corners1[m_candidates[0].index1]->progress;
+        float f2 = corners2[m_candidates[0].index2]->progress;
+        m_mapping.assign({ { f1, f2 },
+            { std::fmod(f1 + 0.5f, 1.0f), std::fmod(f2 + 0.5f, 1.0f) } });
+        return;
+    }
+
+    // Build mapping using greedy algorithm
+    m_used1.assign(corners1.size(), false);
+    m_used2.assign(corners2.size(), false);
+    m_next = 0;
+    m_stage = Stage::Try;
+}
+
+void IncrementalFeatureMapper::tryCandidates(size_t& work) {
+    MappingHelper helper(m_mapping, m_used1, m_used2);
+    for (; work > 0 && m_next < m_candidates.size(); ++m_next, --work) {
+        const Candidate& candidate = m_candidates[m_next];
+        helper.addMapping((*m_corners1)[candidate.index1], candidate.index1,
+            (*m_corners2)[candidate.index2], candidate.index2);
+    }
+    if (m_next == m_candidates.size()) {
+        m_stage = Stage::Done;
+    }
 }
 
 float featureDistSquared(const Feature* f1, const Feature* f2) {
@@ -6,6 +6,75 @@
 
 namespace RoundedPolygon {
 
+/**
+ * IncrementalFeatureMapper computes the mapping of featureMapper() in
+ * bounded steps, so that mapping shapes with many corners can be spread over
+ * several calls instead of blocking one of them.
+ *
+ * Every candidate pair of corners is measured, the candidates are sorted by
+ * distance with a bottom-up merge sort, and then tried from the closest on.
+ * One unit of work measures, moves or tries one candidate. Its buffers are
+ * kept for the next mapping.
+ */
+class IncrementalFeatureMapper {
+public:
+    /**
+     * Start mapping two lists of corners, which must outlive the mapping.
+     */
+    void reset(const std::vector<const ProgressableFeature*>& corners1,
+        const std::vector<const ProgressableFeature*>& corners2);
+
+    /**
+     * Run at most work units of work. Returns true once mapping is done.
+     */
+    bool advance(size_t work);
+
+    [[nodiscard]] bool done() const { return m_stage == Stage::Done; }
+
+    /**
+     * The finished mapping.
+     */
+    [[nodiscard]] DoubleMapper mapper() const {
+        return DoubleMapper(m_mapping);
+    }
+
+private:
+    enum class Stage { Measure, Sort, Try, Done };
+
+    struct Candidate {
+        float distance;
+        size_t index1;
+        size_t index2;
+    };
+
+    const std::vector<const ProgressableFeature*>* m_corners1 = nullptr;
+    const std::vector<const ProgressableFeature*>* m_corners2 = nullptr;
+    Stage m_stage = Stage::Done;
+    // Next candidate to measure or try
+    size_t m_index1 = 0;
+    size_t m_index2 = 0;
+    size_t m_next = 0;
+    // Merge sort state: the runs of m_width candidates from m_low are being
+    // merged from m_candidates onto the end of m_merged, up to m_left and
+    // m_right
+    size_t m_width = 0;
+    size_t m_low = 0;
+    size_t m_left = 0;
+    size_t m_right = 0;
+
+    std::vector<Candidate> m_candidates;
+    std::vector<Candidate> m_merged;
+    std::vector<std::pair<float, float>> m_mapping;
+    std::vector<bool> m_used1;
+    std::vector<bool> m_used2;
+
+    void measure(size_t& work);
+    void sort(size_t& work);
+    void tryCandidates(size_t& work);
+    void startSort();
+    void startTrying();
+};
+
 /**
  * Creates a DoubleMapper that maps between features of two shapes.
  * This is used to determine how to match curves between shapes for morphing.
@@ -14,6 +83,14 @@ namespace RoundedPolygon {
     const std::vector<ProgressableFeature>& features1,
     const std::vector<ProgressableFeature>& features2);
 
+/**
+ * Creates a DoubleMapper from features that are already filtered down to
+ * corners, such as the ones cached by PreparedShape.
+ */
+[[nodiscard]] DoubleMapper featureMapper(
+    const std::vector<const ProgressableFeature*>& corners1,
+    const std::vector<const ProgressableFeature*>& corners2);
+
 /**
  * Returns the squared distance between two features.
  * Returns MAX_VALUE if features cannot be mapped (e.g., convex to concave).
@@ -1,15 +1,204 @@
 #include "Morph.hpp"
 #include <algorithm>
+#include <cmath>
+#include <limits>
 #include <memory>
 #include <optional>
 #include <stdexcept>
 
 namespace RoundedPolygon {
 
+namespace {
+
+// Shapes with the same features number their feature cubics the same way, so
+// the spans recorded on one apply to the other
+bool sameFeatures(
+    const RoundedPolygonShape& shape1, const RoundedPolygonShape& shape2) {
+    const auto& features1 = shape1.features();
+    const auto& features2 = shape2.features();
+    if (features1.size() != features2.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < features1.size(); ++i) {
+        const Feature& feature1 = *features1[i];
+        const Feature& feature2 = *features2[i];
+        if (feature1.isEdge() != feature2.isEdge() ||
+            feature1.isConvexCorner() != feature2.isConvexCorner() ||
+            feature1.cubics().size() != feature2.cubics().size()) {
+            return false;
+        }
+        for (size_t j = 0; j < feature1.cubics().size(); ++j) {
+            if (feature1.cubics()[j].zeroLength() !=
+                feature2.cubics()[j].zeroLength()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// The part of cubic between the curve parameters startT and endT
+Cubic segment(const Cubic& cubic, float startT, float endT) {
+    Cubic rest = startT > 0.0f ? cubic.split(startT).second : cubic;
+    const float remaining = 1.0f - startT;
+    if (endT >= 1.0f || remaining <= 0.0f) {
+        return rest;
+    }
+    return rest.split((endT - startT) / remaining).first;
+}
+
+// Cuts one side of each pair of match again from the feature cubics of shape
+void recut(const RoundedPolygonShape& shape,
+    const std::vector<MatchSource>& sources, bool startSide,
+    std::vector<std::pair<Cubic, Cubic>>& match) {
+    std::vector<const Cubic*> cubics;
+    for (const auto& feature : shape.features()) {
+        for (const auto& cubic : feature->cubics()) {
+            cubics.push_back(&cubic);
+        }
+    }
+
+    for (size_t i = 0; i < match.size(); ++i) {
+        const MatchSource& source = sources[i];
+        const CubicSpan& span = startSide ? source.start : source.end;
+        const auto& fold = startSide ? source.startFold : source.endFold;
+        Cubic& cubic = startSide ? match[i].first : match[i].second;
+
+        cubic = segment(*cubics[span.cubic], span.startT, span.endT);
+        if (fold.has_value()) {
+            Point anchor = cubics[fold->cubic]->pointOnCurve(fold->endT);
+            cubic.points()[6] = anchor.x;
+            cubic.points()[7] = anchor.y;
+        }
+    }
+}
+
+// Whether progress sits on an end of the morph, where the matched cubics are
+// used as they are instead of interpolated
+bool isAtEnd(float progress, float end) {
+    return std::abs(progress - end) < AngleEpsilon;
+}
+
+} // anonymous namespace
+
 Morph::Morph(const RoundedPolygonShape& start, const RoundedPolygonShape& end)
-    : m_start(start)
-    , m_end(end)
-    , m_morphMatch(match(start, end)) {}
+    : Morph(PreparedShape::prepare(start), PreparedShape::prepare(end)) {}
+
+Morph::Morph(std::shared_ptr<const PreparedShape> start,
+    std::shared_ptr<const PreparedShape> end)
+    : m_start(std::move(start))
+    , m_end(std::move(end)) {
+    MorphMatcher matcher;
+    match(matcher);
+}
+
+Morph::Morph(std::shared_ptr<const PreparedShape> start,
+    std::shared_ptr<const PreparedShape> end,
+    std::vector<std::pair<Cubic, Cubic>> morphMatch,
+    std::vector<MatchSource> sources)
+    : m_start(std::move(start))
+    , m_end(std::move(end))
+    , m_morphMatch(std::move(morphMatch))
+    , m_sources(std::move(sources)) {}
+
+void Morph::reset(
+    const RoundedPolygonShape& start, const RoundedPolygonShape& end) {
+    reset(PreparedShape::prepare(start), PreparedShape::prepare(end));
+}
+
+void Morph::reset(std::shared_ptr<const PreparedShape> start,
+    std::shared_ptr<const PreparedShape> end) {
+    m_start = std::move(start);
+    m_end = std::move(end);
+    auto& matcher = m_resetMatcher.matcher;
+    if (matcher == nullptr) {
+        matcher = std::make_unique<MorphMatcher>();
+    }
+    match(*matcher);
+}
+
+bool Morph::update(const std::shared_ptr<const PreparedShape>& start,
+    const std::shared_ptr<const PreparedShape>& end) {
+    const bool startChanged = start != m_start;
+    const bool endChanged = end != m_end;
+    if (!startChanged && !endChanged) {
+        return true;
+    }
+    if (m_sources.size() != m_morphMatch.size() ||
+        (startChanged && !sameFeatures(m_start->shape(), start->shape())) ||
+        (endChanged && !sameFeatures(m_end->shape(), end->shape()))) {
+        return false;
+    }
+
+    if (startChanged) {
+        recut(start->shape(), m_sources, true, m_morphMatch);
+        m_start = start;
+    }
+    if (endChanged) {
+        recut(end->shape(), m_sources, false, m_morphMatch);
+        m_end = end;
+    }
+    return true;
+}
+
+Morph Morph::canonical(std::shared_ptr<const PreparedShape> start,
+    std::shared_ptr<const PreparedShape> end, size_t cubicCount) {
+    const auto& startCubics = start->canonical(cubicCount).cubics();
+    const auto& endCubics = end->canonical(cubicCount).cubics();
+
+    std::vector<std::pair<Cubic, Cubic>> morphMatch;
+    morphMatch.reserve(cubicCount);
+    for (size_t i = 0; i < cubicCount; ++i) {
+        morphMatch.emplace_back(startCubics[i], endCubics[i]);
+    }
+    return Morph(std::move(start), std::move(end), std::move(morphMatch));
+}
+
+Morph Morph::reversed() const {
+    std::vector<std::pair<Cubic, Cubic>> reversedMatch;
+    reversedMatch.reserve(m_morphMatch.size());
+    for (const auto& [startCubic, endCubic] : m_morphMatch) {
+        reversedMatch.emplace_back(endCubic, startCubic);
+    }
+    std::vector<MatchSource> reversedSources;
+    reversedSources.reserve(m_sources.size());
+    for (const auto& source : m_sources) {
+        reversedSources.push_back(
+            { source.end, source.start, source.endFold, source.startFold });
+    }
+    Morph result(m_end, m_start, std::move(reversedMatch),
+        std::move(reversedSources));
+    result.m_transformed = m_transformed;
+    return result;
+}
+
+Morph Morph::transformed(const PointTransformer& startTransform,
+    const PointTransformer& endTransform) const {
+    std::vector<std::pair<Cubic, Cubic>> transformedMatch;
+    transformedMatch.reserve(m_morphMatch.size());
+    for (const auto& [startCubic, endCubic] : m_morphMatch) {
+        transformedMatch.emplace_back(
+            startTransform ? startCubic.transformed(startTransform)
+                           : startCubic,
+            endTransform ? endCubic.transformed(endTransform) : endCubic);
+    }
+
+    // The end shapes are only needed for bounds, and stay unmeasured. They
+    // keep the features of the original shapes, and with them the sources.
+    auto start = m_start;
+    if (startTransform) {
+        start = PreparedShape::prepare(
+            m_start->shape().transformed(startTransform));
+    }
+    auto end = m_end;
+    if (endTransform) {
+        end = PreparedShape::prepare(m_end->shape().transformed(endTransform));
+    }
+    Morph result(std::move(start), std::move(end),
+        std::move(transformedMatch), m_sources);
+    result.m_transformed = true;
+    return result;
+}
 
 std::vector<Cubic> Morph::asCubics(float progress) const {
     std::vector<Cubic> result;
@@ -18,18 +207,25 @@ std::vector<Cubic> Morph::asCubics(float progress) const {
     Cubic* firstCubic = nullptr;
     Cubic* lastCubic = nullptr;
 
+    // The ends of the morph are its matched cubics as they are
+    const bool atStart = isAtEnd(progress, 0.0f);
+    const bool atEnd = isAtEnd(progress, 1.0f);
+
     for (size_t i = 0; i < m_morphMatch.size(); ++i) {
         const auto& [startCubic, endCubic] = m_morphMatch[i];
 
-        // Interpolate all 8 points
-        std::array<float, 8> points;
-        for (size_t j = 0; j < 8; ++j) {
-            points[j] = interpolate(
-                startCubic.points()[j], endCubic.points()[j], progress);
+        if (atStart || atEnd) {
+            result.push_back(atStart ? startCubic : endCubic);
+        } else {
+            // Interpolate all 8 points
+            std::array<float, 8> points;
+            for (size_t j = 0; j < 8; ++j) {
+                points[j] = interpolate(
+                    startCubic.points()[j], endCubic.points()[j], progress);
+            }
+            result.emplace_back(points);
         }
 
-        result.emplace_back(points);
-
         if (firstCubic == nullptr) {
             firstCubic = &result.back();
         }
@@ -52,15 +248,23 @@ void Morph::forEachCubic(float progress,
     const std::function<void(const MutableCubic&)>& callback) const {
     MutableCubic mutableCubic;
 
+    // The ends of the morph are its matched cubics as they are
+    const bool atStart = isAtEnd(progress, 0.0f);
+    const bool atEnd = isAtEnd(progress, 1.0f);
+
     for (const auto& [startCubic, endCubic] : m_morphMatch) {
-        mutableCubic.interpolate(startCubic, endCubic, progress);
+        if (atStart || atEnd) {
+            mutableCubic.points() = (atStart ? startCubic : endCubic).points();
+        } else {
+            mutableCubic.interpolate(startCubic, endCubic, progress);
+        }
         callback(mutableCubic);
     }
 }
 
 std::array<float, 4> Morph::calculateBounds(bool approximate) const {
-    auto startBounds = m_start.calculateBounds(approximate);
-    auto endBounds = m_end.calculateBounds(approximate);
+    auto startBounds = m_start->calculateBounds(approximate);
+    auto endBounds = m_end->calculateBounds(approximate);
 
     return { std::min(startBounds[0], endBounds[0]),
         std::min(startBounds[1], endBounds[1]),
@@ -68,110 +272,66 @@ std::array<float, 4> Morph::calculateBounds(bool approximate) const {
         std::max(startBounds[3], endBounds[3]) };
 }
 
-std::array<float, 4> Morph::calculateMaxBounds() const {
-    auto startBounds = m_start.calculateMaxBounds();
-    auto endBounds = m_end.calculateMaxBounds();
-
-    return { std::min(startBounds[0], endBounds[0]),
-        std::min(startBounds[1], endBounds[1]),
-        std::max(startBounds[2], endBounds[2]),
-        std::max(startBounds[3], endBounds[3]) };
-}
-
-std::vector<std::pair<Cubic, Cubic>> Morph::match(
-    const RoundedPolygonShape& p1, const RoundedPolygonShape& p2) {
-    // Measure polygons to get progress values for each cubic
-    auto measurer = std::make_shared<LengthMeasurer>();
-    auto measuredPolygon1 = MeasuredPolygon::measurePolygon(measurer, p1);
-    auto measuredPolygon2 = MeasuredPolygon::measurePolygon(measurer, p2);
-
-    // Get features for mapping
-    const auto& features1 = measuredPolygon1.features();
-    const auto& features2 = measuredPolygon2.features();
-
-    // Map features between shapes
-    DoubleMapper doubleMapper = featureMapper(features1, features2);
-
-    // Find the cut point on polygon 2 that corresponds to progress 0 on
-    // polygon 1
-    float polygon2CutPoint = doubleMapper.map(0.0f);
-
-    // Cut and rotate polygon 2 so it aligns with polygon 1
-    MeasuredPolygon bs1 = measuredPolygon1;
-    MeasuredPolygon bs2 = measuredPolygon2.cutAndShift(polygon2CutPoint);
-
-    // Match cubics between the two shapes
-    std::vector<std::pair<Cubic, Cubic>> result;
-
-    size_t i1 = 0;
-    size_t i2 = 0;
-
-    // Use optional to track current cubic state (including cut results)
-    std::optional<MeasuredCubic> b1Opt;
-    std::optional<MeasuredCubic> b2Opt;
+std::array<float, 4> Morph::boundsAt(float progress, bool approximate) const {
+    float minX = std::numeric_limits<float>::max();
+    float minY = std::numeric_limits<float>::max();
+    float maxX = std::numeric_limits<float>::lowest();
+    float maxY = std::numeric_limits<float>::lowest();
 
-    if (i1 < bs1.size()) {
-        b1Opt = bs1[i1++];
-    }
-    if (i2 < bs2.size()) {
-        b2Opt = bs2[i2++];
+    MutableCubic cubic;
+    std::array<float, 4> cubicBounds;
+    for (const auto& [startCubic, endCubic] : m_morphMatch) {
+        cubic.interpolate(startCubic, endCubic, progress);
+        cubic.calculateBounds(cubicBounds, approximate);
+        minX = std::min(minX, cubicBounds[0]);
+        minY = std::min(minY, cubicBounds[1]);
+        maxX = std::max(maxX, cubicBounds[2]);
+        maxY = std::max(maxY, cubicBounds[3]);
     }
 
-    while (b1Opt.has_value() && b2Opt.has_value()) {
-        const MeasuredCubic& b1 = *b1Opt;
-        const MeasuredCubic& b2 = *b2Opt;
-
-        // Get end progress values (in shape1's perspective)
-        float b1a = (i1 == bs1.size()) ? 1.0f : b1.endOutlineProgress();
-        float b2a;
-        if (i2 == bs2.size()) {
-            b2a = 1.0f;
-        } else {
-            b2a = doubleMapper.mapBack(positiveModulo(
-                b2.endOutlineProgress() + polygon2CutPoint, 1.0f));
-        }
-
-        float minb = std::min(b1a, b2a);
+    return { minX, minY, maxX, maxY };
+}
 
-        // Cut and get segments
-        MeasuredCubic seg1 = b1;
-        MeasuredCubic seg2 = b2;
+std::array<float, 4> Morph::sweptBounds(
+    float fromProgress, float toProgress) const {
+    float minX = std::numeric_limits<float>::max();
+    float minY = std::numeric_limits<float>::max();
+    float maxX = std::numeric_limits<float>::lowest();
+    float maxY = std::numeric_limits<float>::lowest();
 
-        if (b1a > minb + AngleEpsilon) {
-            auto [cut1, cut2] = b1.cutAtProgress(minb, *measurer);
-            seg1 = cut1;
-            b1Opt = cut2;
-        } else {
-            if (i1 < bs1.size()) {
-                b1Opt = bs1[i1++];
-            } else {
-                b1Opt.reset();
-            }
+    for (const auto& [startCubic, endCubic] : m_morphMatch) {
+        const auto& p1 = startCubic.points();
+        const auto& p2 = endCubic.points();
+        for (size_t i = 0; i < 8; i += 2) {
+            float fromX = interpolate(p1[i], p2[i], fromProgress);
+            float fromY = interpolate(p1[i + 1], p2[i + 1], fromProgress);
+            float toX = interpolate(p1[i], p2[i], toProgress);
+            float toY = interpolate(p1[i + 1], p2[i + 1], toProgress);
+            minX = std::min({ minX, fromX, toX });
+            minY = std::min({ minY, fromY, toY });
+            maxX = std::max({ maxX, fromX, toX });
+            maxY = std::max({ maxY, fromY, toY });
         }
+    }
 
-        if (b2a > minb + AngleEpsilon) {
-            auto [cut1, cut2] = b2.cutAtProgress(
-                positiveModulo(doubleMapper.map(minb) - polygon2CutPoint, 1.0f),
-                *measurer);
-            seg2 = cut1;
-            b2Opt = cut2;
-        } else {
-            if (i2 < bs2.size()) {
-                b2Opt = bs2[i2++];
-            } else {
-                b2Opt.reset();
-            }
-        }
+    return { minX, minY, maxX, maxY };
+}
 
-        result.emplace_back(seg1.cubic(), seg2.cubic());
-    }
+std::array<float, 4> Morph::calculateMaxBounds() const {
+    auto startBounds = m_start->calculateMaxBounds();
+    auto endBounds = m_end->calculateMaxBounds();
 
-    if (b1Opt.has_value() || b2Opt.has_value()) {
-        throw std::runtime_error(
-            "Expected both polygon's cubics to be fully matched");
-    }
+    return { std::min(startBounds[0], endBounds[0]),
+        std::min(startBounds[1], endBounds[1]),
+        std::max(startBounds[2], endBounds[2]),
+        std::max(startBounds[3], endBounds[3]) };
+}
 
-    return result;
+void Morph::match(MorphMatcher& matcher) {
+    matcher.reset(m_start, m_end);
+    matcher.run();
+    matcher.takeMatch(m_morphMatch, m_sources);
+    m_transformed = false;
 }
 
 } // namespace RoundedPolygon
@@ -2,8 +2,11 @@
 
 #include "../core/RoundedPolygon.hpp"
 #include "FeatureMapping.hpp"
+#include "MorphMatcher.hpp"
 #include "PolygonMeasure.hpp"
+#include "PreparedShape.hpp"
 #include <functional>
+#include <memory>
 #include <vector>
 
 namespace RoundedPolygon {
@@ -28,6 +31,77 @@ public:
      */
     Morph(const RoundedPolygonShape& start, const RoundedPolygonShape& end);
 
+    /**
+     * Create a morph between two prepared shapes. Their measurements are
+     * shared with every other morph using the same prepared shapes, so
+     * matching against a shape that was already measured skips that work.
+     */
+    Morph(std::shared_ptr<const PreparedShape> start,
+        std::shared_ptr<const PreparedShape> end);
+
+    /**
+     * Rebuild this morph between two other shapes. The match and the
+     * buffers used to compute it keep their storage, so retargeting a morph
+     * repeatedly does not reallocate them. The buffers are made by the first
+     * reset(), and copies of the morph do not share them.
+     */
+    void reset(
+        const RoundedPolygonShape& start, const RoundedPolygonShape& end);
+    void reset(std::shared_ptr<const PreparedShape> start,
+        std::shared_ptr<const PreparedShape> end);
+
+    /**
+     * Move this morph to edited versions of its shapes without matching them
+     * again. Each pair is cut from the same parts of the same feature cubics
+     * as before, so only the control points are derived again, in O(n).
+     *
+     * This only works when every changed shape has the same features as the
+     * shape it replaces: the same kinds and cubic counts, with zero-length
+     * (sharp) cubics in the same places. Otherwise, and for canonical morphs,
+     * this returns false and leaves the morph unchanged; use reset() then.
+     *
+     * The correspondence of the previous match is kept as is, which suits
+     * small edits such as dragging a vertex. A fresh match of very different
+     * shapes can pair their features differently.
+     */
+    [[nodiscard]] bool update(const std::shared_ptr<const PreparedShape>& start,
+        const std::shared_ptr<const PreparedShape>& end);
+
+    /**
+     * Create a morph between the canonical forms of two prepared shapes. The
+     * canonical cubics are paired by index, so once both forms are cached
+     * this takes O(cubicCount) with no feature mapping or cutting. Corners
+     * keep the cubics of where they lie along the outline but are not
+     * matched to each other, so shapes whose corners lie at different places
+     * morph less faithfully than with a regular morph; see CanonicalShape.
+     */
+    [[nodiscard]] static Morph canonical(
+        std::shared_ptr<const PreparedShape> start,
+        std::shared_ptr<const PreparedShape> end,
+        size_t cubicCount = CanonicalShape::DefaultCubicCount);
+
+    /**
+     * Returns the morph from this morph's end shape back to its start shape.
+     *
+     * The reverse match pairs the same cubics with their roles swapped, so it
+     * is derived in O(n) without measuring or mapping the shapes again. The
+     * outline starts at a different point than a freshly matched reverse
+     * morph would, which does not change the rendered shape.
+     */
+    [[nodiscard]] Morph reversed() const;
+
+    /**
+     * Returns this morph with its start and end shapes transformed
+     * separately. The match is reused by transforming its control points, so
+     * rotated or scaled variants of the shapes are not matched again. An
+     * empty transformer leaves that end unchanged.
+     *
+     * The result is exact for affine transforms (rotation, scale,
+     * translation, skew), which map cubics to cubics.
+     */
+    [[nodiscard]] Morph transformed(const PointTransformer& startTransform,
+        const PointTransformer& endTransform) const;
+
     /**
      * Returns a representation of the morph at a given progress value
      * as a list of Cubics.
@@ -41,7 +115,8 @@ public:
     /**
      * Iterates over cubics at the given progress, calling the callback
      * for each one. More efficient than asCubics() as it reuses a
-     * MutableCubic instance.
+     * MutableCubic instance. At a progress of 0 or 1 the matched cubics are
+     * passed as they are, without interpolating.
      *
      * @param progress Value from 0 to 1 determining the morph state.
      * @param callback Function called for each cubic.
@@ -58,12 +133,44 @@ public:
     [[nodiscard]] std::array<float, 4> calculateBounds(
         bool approximate = true) const;
 
+    /**
+     * Calculate the axis-aligned bounding box of the morph at the given
+     * progress, in a single pass over the interpolated cubics. Unlike
+     * calculateBounds(), this follows overshooting progress values outside
+     * of [0, 1].
+     *
+     * @param progress Morph progress to measure at.
+     * @param approximate When true, uses the control points of each cubic
+     *        instead of its exact extremes.
+     */
+    [[nodiscard]] std::array<float, 4> boundsAt(
+        float progress, bool approximate = true) const;
+
+    /**
+     * Calculate a conservative bounding box that contains the morph at
+     * every progress value between fromProgress and toProgress.
+     *
+     * Control points move linearly with progress, so the control points
+     * at both ends of the interval bound the curves at every progress in
+     * between.
+     */
+    [[nodiscard]] std::array<float, 4> sweptBounds(
+        float fromProgress, float toProgress) const;
+
     /**
      * Calculate the maximum bounding box that can hold the shape
      * in any rotation.
      */
     [[nodiscard]] std::array<float, 4> calculateMaxBounds() const;
 
+    [[nodiscard]] const std::shared_ptr<const PreparedShape>& start() const {
+        return m_start;
+    }
+
+    [[nodiscard]] const std::shared_ptr<const PreparedShape>& end() const {
+        return m_end;
+    }
+
     /**
      * Get the matched cubic pairs (for debugging/visualization).
      */
@@ -73,16 +180,44 @@ public:
     }
 
 private:
-    RoundedPolygonShape m_start;
-    RoundedPolygonShape m_end;
+    friend class MorphDiskCache;
+    friend class MorphMatcher;
+
+    Morph(std::shared_ptr<const PreparedShape> start,
+        std::shared_ptr<const PreparedShape> end,
+        std::vector<std::pair<Cubic, Cubic>> morphMatch,
+        std::vector<MatchSource> sources = {});
+
+    std::shared_ptr<const PreparedShape> m_start;
+    std::shared_ptr<const PreparedShape> m_end;
     std::vector<std::pair<Cubic, Cubic>> m_morphMatch;
+    // Where each pair of m_morphMatch was cut from, empty for canonical
+    // morphs
+    std::vector<MatchSource> m_sources;
+    // Whether the match was derived by transformed() rather than made from
+    // the shapes, which keeps it out of MorphDiskCache
+    bool m_transformed = false;
+    // The matcher reset() reuses the buffers of, made on its first call.
+    // Copies of the morph start without one.
+    struct ResetMatcher {
+        ResetMatcher() = default;
+        ResetMatcher(const ResetMatcher& /*other*/) {}
+        ResetMatcher(ResetMatcher&&) noexcept = default;
+        ResetMatcher& operator=(const ResetMatcher& /*other*/) {
+            return *this;
+        }
+        ResetMatcher& operator=(ResetMatcher&&) noexcept = default;
+        ~ResetMatcher() = default;
+
+        std::unique_ptr<MorphMatcher> matcher;
+    };
+    ResetMatcher m_resetMatcher;
 
     /**
-     * Match features between two shapes, creating paired cubics
-     * that can be interpolated.
+     * Match features between m_start and m_end with matcher, filling
+     * m_morphMatch with paired cubics that can be interpolated.
      */
-    static std::vector<std::pair<Cubic, Cubic>> match(
-        const RoundedPolygonShape& p1, const RoundedPolygonShape& p2);
+    void match(MorphMatcher& matcher);
 };
 
 } // namespace RoundedPolygon
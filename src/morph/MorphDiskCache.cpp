@@ -0,0 +1,500 @@
+#include "MorphDiskCache.hpp"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+namespace RoundedPolygon {
+
+namespace {
+
+constexpr char Magic[4] = { 'M', '3', 'M', 'C' };
+
+// Library version the file was written by, zero-padded
+using LibraryVersion = std::array<char, 16>;
+
+LibraryVersion libraryVersion() {
+    constexpr std::string_view version = M3SHAPES_VERSION;
+    static_assert(version.size() < sizeof(LibraryVersion));
+    LibraryVersion result{};
+    std::copy(version.begin(), version.end(), result.begin());
+    return result;
+}
+
+struct Header {
+    char magic[4];
+    uint32_t formatVersion;
+    LibraryVersion libraryVersion;
+    uint32_t entryCount;
+    uint32_t pairCount;
+};
+
+// Entries are sorted by their hashes. lastUsed orders them by when they were
+// last inserted or found, counting up across the writes of the file.
+struct EntryRecord {
+    uint64_t startHash;
+    uint64_t endHash;
+    uint32_t firstPair;
+    uint32_t pairCount;
+    uint32_t startCubics;
+    uint32_t endCubics;
+    uint64_t lastUsed;
+};
+
+struct SpanRecord {
+    uint32_t cubic;
+    float startT;
+    float endT;
+};
+
+struct SourceRecord {
+    // Bit 0 for startFold, bit 1 for endFold
+    uint32_t folds;
+    SpanRecord start;
+    SpanRecord end;
+    SpanRecord startFold;
+    SpanRecord endFold;
+};
+
+static_assert(sizeof(Header) == 32);
+static_assert(sizeof(EntryRecord) == 40);
+static_assert(sizeof(SourceRecord) == 52);
+// Pairs are read from the file as they lie
+static_assert(sizeof(Cubic) == 8 * sizeof(float));
+static_assert(alignof(Cubic) == alignof(float));
+static_assert(std::is_trivially_copyable_v<Cubic>);
+
+// Bytes taken by a file with these counts
+uint64_t fileSize(uint64_t entryCount, uint64_t pairCount) {
+    return sizeof(Header) + entryCount * sizeof(EntryRecord) +
+        pairCount * (2 * sizeof(Cubic) + sizeof(SourceRecord));
+}
+
+SpanRecord spanRecord(const CubicSpan& span) {
+    return { static_cast<uint32_t>(span.cubic), span.startT, span.endT };
+}
+
+CubicSpan cubicSpan(const SpanRecord& record) {
+    return { record.cubic, record.startT, record.endT };
+}
+
+} // anonymous namespace
+
+struct MorphDiskCache::Mapping {
+    QFile file;
+    const EntryRecord* entries = nullptr;
+    uint32_t entryCount = 0;
+    // Two cubics for each pair
+    const Cubic* cubics = nullptr;
+    const SourceRecord* sources = nullptr;
+
+    explicit Mapping(const std::string& path)
+        : file(QString::fromStdString(path)) {}
+
+    [[nodiscard]] Key key(size_t index) const {
+        return { entries[index].startHash, entries[index].endHash };
+    }
+
+    // Map the file and check that its entries lie within it. Files written
+    // by another version, or damaged, are left unmapped.
+    bool map() {
+        if constexpr (std::endian::native != std::endian::little) {
+            return false;
+        }
+        if (!file.open(QIODevice::ReadOnly)) {
+            return false;
+        }
+        const qint64 size = file.size();
+        if (size < static_cast<qint64>(sizeof(Header))) {
+            return false;
+        }
+        const uchar* data = file.map(0, size);
+        if (data == nullptr) {
+            return false;
+        }
+        Header header;
+        std::memcpy(&header, data, sizeof(Header));
+        if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 ||
+            header.formatVersion != FormatVersion ||
+            header.libraryVersion != libraryVersion() ||
+            fileSize(header.entryCount, header.pairCount) !=
+                static_cast<uint64_t>(size)) {
+            return false;
+        }
+
+        const uchar* position = data + sizeof(Header);
+        entries = reinterpret_cast<const EntryRecord*>(position);
+        position += sizeof(EntryRecord) * header.entryCount;
+        cubics = reinterpret_cast<const Cubic*>(position);
+        position += 2 * sizeof(Cubic) * header.pairCount;
+        sources = reinterpret_cast<const SourceRecord*>(position);
+        for (uint32_t i = 0; i < header.entryCount; ++i) {
+            const EntryRecord& entry = entries[i];
+            if (static_cast<uint64_t>(entry.firstPair) + entry.pairCount >
+                    header.pairCount ||
+                (i > 0 && key(i - 1) >= key(i))) {
+                return false;
+            }
+        }
+        entryCount = header.entryCount;
+        return true;
+    }
+
+    // Index of the entry with key, or entryCount if there is none
+    [[nodiscard]] size_t find(const Key& wanted) const {
+        size_t low = 0;
+        size_t high = entryCount;
+        while (low < high) {
+            size_t middle = low + (high - low) / 2;
+            if (key(middle) < wanted) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return low < entryCount && key(low) == wanted ? low : entryCount;
+    }
+};
+
+MorphDiskCache::MorphDiskCache(std::string path)
+    : m_path(std::move(path)) {}
+
+MorphDiskCache::~MorphDiskCache() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    if (m_writer.joinable()) {
+        m_writer.join();
+    }
+    writePending();
+}
+
+std::optional<Morph> MorphDiskCache::find(
+    const std::shared_ptr<const PreparedShape>& start,
+    const std::shared_ptr<const PreparedShape>& end) {
+    const Key key(contentHash(start->shape()), contentHash(end->shape()));
+    const uint32_t startCubics = featureCubicCount(start->shape());
+    const uint32_t endCubics = featureCubicCount(end->shape());
+
+    {
+        std::lock_guard lock(m_mutex);
+        load();
+        auto recent = m_recent.find(key);
+        if (recent != m_recent.end()) {
+            const Entry& entry = *recent->second.entry;
+            if (entry.startCubics != startCubics ||
+                entry.endCubics != endCubics) {
+                return std::nullopt;
+            }
+            recent->second.used = ++m_useCount;
+            return Morph(start, end, entry.match, entry.sources);
+        }
+    }
+
+    // The mapping does not change once loaded
+    const Mapping* mapping = m_mapping.get();
+    size_t index = mapping != nullptr ? mapping->find(key) : 0;
+    if (mapping == nullptr || index == mapping->entryCount) {
+        return std::nullopt;
+    }
+    const EntryRecord& entry = mapping->entries[index];
+    if (entry.startCubics != startCubics || entry.endCubics != endCubics) {
+        return std::nullopt;
+    }
+    const Cubic* cubics = mapping->cubics + 2 * size_t{ entry.firstPair };
+    std::vector<std::pair<Cubic, Cubic>> match;
+    match.reserve(entry.pairCount);
+    for (uint32_t i = 0; i < entry.pairCount; ++i) {
+        match.emplace_back(cubics[2 * i], cubics[2 * i + 1]);
+    }
+    std::vector<MatchSource> sources;
+    sources.reserve(entry.pairCount);
+    for (uint32_t i = 0; i < entry.pairCount; ++i) {
+        const SourceRecord& record = mapping->sources[entry.firstPair + i];
+        MatchSource source{ cubicSpan(record.start), cubicSpan(record.end),
+            std::nullopt, std::nullopt };
+        if ((record.folds & 1u) != 0) {
+            source.startFold = cubicSpan(record.startFold);
+        }
+        if ((record.folds & 2u) != 0) {
+            source.endFold = cubicSpan(record.endFold);
+        }
+        // Sources are only followed by Morph::update(), which needs them to
+        // name cubics of the shapes; without them it matches again instead
+        if (source.start.cubic >= startCubics ||
+            source.end.cubic >= endCubics ||
+            (source.startFold && source.startFold->cubic >= startCubics) ||
+            (source.endFold && source.endFold->cubic >= endCubics)) {
+            sources.clear();
+            break;
+        }
+        sources.push_back(source);
+    }
+
+    if (sources.empty()) {
+        // Not remembered, since writing it would give zeroed sources that
+        // pass the checks above on the next load
+        return Morph(start, end, std::move(match));
+    }
+
+    // Kept with the recent entries, so the next write keeps it over entries
+    // that were not used
+    auto found = std::make_shared<const Entry>(Entry{
+        startCubics, endCubics, std::move(match), std::move(sources) });
+    {
+        std::lock_guard lock(m_mutex);
+        remember(key, found);
+    }
+    return Morph(start, end, found->match, found->sources);
+}
+
+void MorphDiskCache::insert(const Morph& morph) {
+    if (morph.m_sources.size() != morph.m_morphMatch.size() ||
+        morph.m_morphMatch.empty() || morph.m_transformed) {
+        return;
+    }
+    const RoundedPolygonShape& start = morph.m_start->shape();
+    const RoundedPolygonShape& end = morph.m_end->shape();
+    auto entry = std::make_shared<const Entry>(Entry{
+        featureCubicCount(start), featureCubicCount(end), morph.m_morphMatch,
+        morph.m_sources });
+    const Key key(contentHash(start), contentHash(end));
+
+    std::lock_guard lock(m_mutex);
+    load();
+    remember(key, std::move(entry));
+    m_dirty = true;
+    m_lastInsert = std::chrono::steady_clock::now();
+    if (!m_writer.joinable()) {
+        m_writer = std::thread([this] { writerLoop(); });
+    }
+    m_wake.notify_all();
+}
+
+void MorphDiskCache::flush() {
+    writePending();
+}
+
+void MorphDiskCache::load() {
+    if (m_loaded) {
+        return;
+    }
+    m_loaded = true;
+    auto mapping = std::make_unique<Mapping>(m_path);
+    if (mapping->map()) {
+        m_mapping = std::move(mapping);
+    }
+}
+
+void MorphDiskCache::remember(
+    const Key& key, std::shared_ptr<const Entry> entry) {
+    m_recent.insert_or_assign(key, Recent{ std::move(entry), ++m_useCount });
+    if (m_recent.size() > Capacity) {
+        m_recent.erase(std::min_element(m_recent.begin(), m_recent.end(),
+            [](const auto& a, const auto& b) {
+                return a.second.used < b.second.used;
+            }));
+    }
+}
+
+void MorphDiskCache::writerLoop() {
+    std::unique_lock lock(m_mutex);
+    while (!m_stopping) {
+        m_wake.wait(lock, [this] { return m_dirty || m_stopping; });
+        // Each insert restarts the delay, so a burst of inserts goes out
+        // with one write
+        while (!m_stopping &&
+               std::chrono::steady_clock::now() < m_lastInsert + WriteDelay) {
+            m_wake.wait_until(lock, m_lastInsert + WriteDelay);
+        }
+        lock.unlock();
+        writePending();
+        lock.lock();
+    }
+}
+
+void MorphDiskCache::writePending() {
+    // Taking the entries under the write lock keeps an older snapshot from
+    // being written after a newer one
+    std::lock_guard writeLock(m_writeMutex);
+    std::map<Key, Recent> recent;
+    {
+        std::lock_guard lock(m_mutex);
+        if (!m_dirty) {
+            return;
+        }
+        recent = m_recent;
+        m_dirty = false;
+    }
+    write(recent);
+}
+
+void MorphDiskCache::write(const std::map<Key, Recent>& recent) {
+    if constexpr (std::endian::native != std::endian::little) {
+        return;
+    }
+
+    // The most recently used entries are kept: those used by this process,
+    // which are newer than any in the file, then those of the file. Each is
+    // its key, when it was last used, and either the entry or the index of
+    // the file entry.
+    struct Source {
+        Key key;
+        uint64_t lastUsed;
+        const Entry* entry;
+        size_t fileIndex;
+    };
+    const Mapping* mapping = m_mapping.get();
+    std::vector<Source> fileEntries;
+    uint64_t fileLastUsed = 0;
+    for (size_t i = 0; mapping != nullptr && i < mapping->entryCount; ++i) {
+        const uint64_t lastUsed = mapping->entries[i].lastUsed;
+        fileLastUsed = std::max(fileLastUsed, lastUsed);
+        if (!recent.contains(mapping->key(i))) {
+            fileEntries.push_back({ mapping->key(i), lastUsed, nullptr, i });
+        }
+    }
+
+    std::vector<Source> entries;
+    entries.reserve(recent.size() + fileEntries.size());
+    for (const auto& [key, recentEntry] : recent) {
+        entries.push_back({ key, fileLastUsed + recentEntry.used,
+            recentEntry.entry.get(), 0 });
+    }
+    auto byRecency = [](const Source& a, const Source& b) {
+        return a.lastUsed > b.lastUsed;
+    };
+    std::sort(entries.begin(), entries.end(), byRecency);
+    std::sort(fileEntries.begin(), fileEntries.end(), byRecency);
+    entries.insert(entries.end(), fileEntries.begin(), fileEntries.end());
+    entries.resize(std::min(entries.size(), Capacity));
+    std::sort(entries.begin(), entries.end(),
+        [](const Source& a, const Source& b) { return a.key < b.key; });
+
+    uint64_t pairCount = 0;
+    for (const auto& source : entries) {
+        pairCount += source.entry != nullptr
+            ? source.entry->match.size()
+            : mapping->entries[source.fileIndex].pairCount;
+    }
+    std::vector<std::byte> data(fileSize(entries.size(), pairCount));
+    std::byte* records = data.data() + sizeof(Header);
+    std::byte* pairs = records + sizeof(EntryRecord) * entries.size();
+    std::byte* sources = pairs + 2 * sizeof(Cubic) * pairCount;
+
+    Header header{};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.formatVersion = FormatVersion;
+    header.libraryVersion = libraryVersion();
+    header.entryCount = static_cast<uint32_t>(entries.size());
+    header.pairCount = static_cast<uint32_t>(pairCount);
+    std::memcpy(data.data(), &header, sizeof(Header));
+
+    uint32_t nextPair = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const Source& source = entries[i];
+        EntryRecord record{};
+        record.startHash = source.key.first;
+        record.endHash = source.key.second;
+        record.firstPair = nextPair;
+        record.lastUsed = source.lastUsed;
+        std::byte* pairsAt = pairs + 2 * sizeof(Cubic) * nextPair;
+        std::byte* sourcesAt = sources + sizeof(SourceRecord) * nextPair;
+
+        if (source.entry == nullptr) {
+            // Copied as it is from the file
+            const EntryRecord& old = mapping->entries[source.fileIndex];
+            record.pairCount = old.pairCount;
+            record.startCubics = old.startCubics;
+            record.endCubics = old.endCubics;
+            std::memcpy(pairsAt, mapping->cubics + 2 * size_t{ old.firstPair },
+                2 * sizeof(Cubic) * old.pairCount);
+            std::memcpy(sourcesAt, mapping->sources + old.firstPair,
+                sizeof(SourceRecord) * old.pairCount);
+        } else {
+            const Entry& entry = *source.entry;
+            record.pairCount = static_cast<uint32_t>(entry.match.size());
+            record.startCubics = entry.startCubics;
+            record.endCubics = entry.endCubics;
+            for (size_t j = 0; j < entry.match.size(); ++j) {
+                std::memcpy(pairsAt + 2 * sizeof(Cubic) * j,
+                    &entry.match[j].first, sizeof(Cubic));
+                std::memcpy(pairsAt + (2 * j + 1) * sizeof(Cubic),
+                    &entry.match[j].second, sizeof(Cubic));
+            }
+            for (size_t j = 0; j < entry.sources.size(); ++j) {
+                const MatchSource& matchSource = entry.sources[j];
+                SourceRecord sourceRecord{};
+                sourceRecord.start = spanRecord(matchSource.start);
+                sourceRecord.end = spanRecord(matchSource.end);
+                if (matchSource.startFold) {
+                    sourceRecord.folds |= 1u;
+                    sourceRecord.startFold = spanRecord(*matchSource.startFold);
+                }
+                if (matchSource.endFold) {
+                    sourceRecord.folds |= 2u;
+                    sourceRecord.endFold = spanRecord(*matchSource.endFold);
+                }
+                std::memcpy(sourcesAt + sizeof(SourceRecord) * j,
+                    &sourceRecord, sizeof(SourceRecord));
+            }
+        }
+        nextPair += record.pairCount;
+        std::memcpy(
+            records + sizeof(EntryRecord) * i, &record, sizeof(EntryRecord));
+    }
+
+    const QString path = QString::fromStdString(m_path);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(reinterpret_cast<const char*>(data.data()),
+            static_cast<qint64>(data.size()));
+        file.commit();
+    }
+}
+
+uint64_t MorphDiskCache::contentHash(const RoundedPolygonShape& shape) {
+    // 64-bit FNV-1a over the kinds and cubics of the features and the
+    // center, which are all that matching looks at
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](uint32_t word) {
+        for (int byte = 0; byte < 4; ++byte) {
+            hash ^= (word >> (byte * 8)) & 0xffu;
+            hash *= 1099511628211ull;
+        }
+    };
+    mix(static_cast<uint32_t>(shape.features().size()));
+    for (const auto& feature : shape.features()) {
+        mix(feature->isConvexCorner() ? 1u
+                : feature->isConcaveCorner() ? 2u
+                                              : 0u);
+        mix(static_cast<uint32_t>(feature->cubics().size()));
+        for (const auto& cubic : feature->cubics()) {
+            for (float value : cubic.points()) {
+                mix(std::bit_cast<uint32_t>(value));
+            }
+        }
+    }
+    mix(std::bit_cast<uint32_t>(shape.centerX()));
+    mix(std::bit_cast<uint32_t>(shape.centerY()));
+    return hash;
+}
+
+uint32_t MorphDiskCache::featureCubicCount(const RoundedPolygonShape& shape) {
+    size_t count = 0;
+    for (const auto& feature : shape.features()) {
+        count += feature->cubics().size();
+    }
+    return static_cast<uint32_t>(count);
+}
+
+} // namespace RoundedPolygon
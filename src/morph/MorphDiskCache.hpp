@@ -0,0 +1,131 @@
+#pragma once
+
+#include "Morph.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace RoundedPolygon {
+
+/**
+ * MorphDiskCache keeps the matches of morphs in a file, so that a later
+ * process morphing the same shapes can skip matching them. Entries are keyed
+ * by hashes of the content of both shapes, and the whole file is dropped
+ * when it was written by another version of the library.
+ *
+ * The file is mapped into memory the first time the cache is used, and its
+ * entries are read from the mapping when they are looked up. Entries
+ * inserted or found by this process are kept in memory, up to Capacity of
+ * them, dropping the least recently used. They are written out on a
+ * background thread once no insert has come for WriteDelay, together with
+ * the entries of the file, replacing it atomically. The file keeps the
+ * Capacity most recently used entries.
+ *
+ * The cache may be used from several threads. Canonical morphs are not
+ * cached, as they take no matching.
+ */
+class MorphDiskCache {
+public:
+    // Version of the file format, stored in each file with the library's
+    static constexpr uint32_t FormatVersion = 1;
+
+    // Entries kept in the file
+    static constexpr size_t Capacity = 1024;
+
+    // Time without inserts to wait for before writing the file
+    static constexpr std::chrono::milliseconds WriteDelay{ 1000 };
+
+    explicit MorphDiskCache(std::string path);
+
+    MorphDiskCache(const MorphDiskCache&) = delete;
+    MorphDiskCache& operator=(const MorphDiskCache&) = delete;
+
+    /**
+     * Writes any pending entries before returning.
+     */
+    ~MorphDiskCache();
+
+    [[nodiscard]] const std::string& path() const { return m_path; }
+
+    /**
+     * The morph between start and end built from a cached match, or
+     * nothing if their match is not cached.
+     */
+    [[nodiscard]] std::optional<Morph> find(
+        const std::shared_ptr<const PreparedShape>& start,
+        const std::shared_ptr<const PreparedShape>& end);
+
+    /**
+     * Cache the match of morph, to be written with the next write.
+     * Canonical morphs and morphs derived from another by transformed(),
+     * whose match was not made from their shapes, are ignored.
+     */
+    void insert(const Morph& morph);
+
+    /**
+     * Write pending entries now, on the calling thread. Errors writing the
+     * file are ignored, as with background writes; the cache stays usable
+     * without it.
+     */
+    void flush();
+
+private:
+    // Content hashes of the start and end shapes
+    using Key = std::pair<uint64_t, uint64_t>;
+
+    struct Entry {
+        // Feature cubics of each shape, to reject colliding hashes
+        uint32_t startCubics;
+        uint32_t endCubics;
+        std::vector<std::pair<Cubic, Cubic>> match;
+        std::vector<MatchSource> sources;
+    };
+
+    struct Recent {
+        std::shared_ptr<const Entry> entry;
+        // Uses of the cache by this process up to the last use of entry
+        uint64_t used;
+    };
+
+    struct Mapping;
+
+    const std::string m_path;
+
+    std::mutex m_mutex;
+    // The file as it was when first used, or null if there was none
+    std::unique_ptr<const Mapping> m_mapping;
+    bool m_loaded = false;
+    // Entries inserted or found by this process, which take precedence over
+    // the file
+    std::map<Key, Recent> m_recent;
+    uint64_t m_useCount = 0;
+    bool m_dirty = false;
+    std::chrono::steady_clock::time_point m_lastInsert;
+
+    // Serializes writes from the writer thread and flush()
+    std::mutex m_writeMutex;
+    std::condition_variable m_wake;
+    std::thread m_writer;
+    bool m_stopping = false;
+
+    void load();
+    // Keep entry as the most recently used, dropping the least recently used
+    // beyond Capacity. Called with m_mutex held.
+    void remember(const Key& key, std::shared_ptr<const Entry> entry);
+    void writerLoop();
+    void writePending();
+    void write(const std::map<Key, Recent>& recent);
+    [[nodiscard]] static uint64_t contentHash(const RoundedPolygonShape& shape);
+    [[nodiscard]] static uint32_t featureCubicCount(
+        const RoundedPolygonShape& shape);
+};
+
+} // namespace RoundedPolygon
@@ -0,0 +1,378 @@
+#include "MorphMatcher.hpp"
+#include "Morph.hpp"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace RoundedPolygon {
+
+namespace {
+
+// Kind and cubic count of a feature. Shapes whose features have the same
+// signatures in the same cyclic order can be matched feature by feature.
+using FeatureSignature = std::pair<int, size_t>;
+
+void signatures(
+    const RoundedPolygonShape& shape, std::vector<FeatureSignature>& result) {
+    result.clear();
+    for (const auto& feature : shape.features()) {
+        int kind = feature->isEdge() ? 0 : feature->isConvexCorner() ? 1 : 2;
+        result.emplace_back(kind, feature->cubics().size());
+    }
+}
+
+// Middle of a feature relative to its shape's center
+Point featurePoint(const Feature& feature, const Point& center) {
+    const auto& cubics = feature.cubics();
+    return Point((cubics.front().anchor0X() + cubics.back().anchor1X()) / 2.0f,
+               (cubics.front().anchor0Y() + cubics.back().anchor1Y()) / 2.0f) -
+           center;
+}
+
+// Finds the rotations of sequence2 that equal sequence1, in O(n) using the
+// Knuth-Morris-Pratt failure function, and returns the one that moves the
+// first feature of shape 1 the least
+std::optional<size_t> bestRotation(const RoundedPolygonShape& shape1,
+    const RoundedPolygonShape& shape2, std::vector<FeatureSignature>& sequence1,
+    std::vector<FeatureSignature>& sequence2, std::vector<size_t>& failure) {
+    signatures(shape1, sequence1);
+    signatures(shape2, sequence2);
+    const size_t n = sequence1.size();
+    if (n == 0 || sequence2.size() != n) {
+        return std::nullopt;
+    }
+
+    failure.assign(n, 0);
+    for (size_t i = 1, k = 0; i < n; ++i) {
+        while (k > 0 && sequence1[i] != sequence1[k]) {
+            k = failure[k - 1];
+        }
+        if (sequence1[i] == sequence1[k]) {
+            ++k;
+        }
+        failure[i] = k;
+    }
+
+    const Point start =
+        featurePoint(*shape1.features()[0], shape1.center());
+    std::optional<size_t> best;
+    float bestDistance = std::numeric_limits<float>::max();
+    for (size_t i = 0, k = 0; i + 1 < 2 * n; ++i) {
+        const auto& signature = sequence2[i % n];
+        while (k > 0 && signature != sequence1[k]) {
+            k = failure[k - 1];
+        }
+        if (signature == sequence1[k]) {
+            ++k;
+        }
+        if (k == n) {
+            const size_t rotation = i + 1 - n;
+            float distance =
+                (featurePoint(*shape2.features()[rotation], shape2.center()) -
+                    start)
+                    .getDistance();
+            if (distance < bestDistance) {
+                best = rotation;
+                bestDistance = distance;
+            }
+            k = failure[k - 1];
+        }
+    }
+    return best;
+}
+
+// Pairs the cubics of structurally identical shapes directly into result,
+// and the feature cubics they are from into sources. Returns false when
+// their features differ.
+bool matchIdentical(const RoundedPolygonShape& shape1,
+    const RoundedPolygonShape& shape2, std::vector<FeatureSignature>& sequence1,
+    std::vector<FeatureSignature>& sequence2, std::vector<size_t>& failure,
+    std::vector<size_t>& offsets, std::vector<std::pair<Cubic, Cubic>>& result,
+    std::vector<MatchSource>& sources) {
+    auto rotation =
+        bestRotation(shape1, shape2, sequence1, sequence2, failure);
+    if (!rotation.has_value()) {
+        return false;
+    }
+
+    const auto& features1 = shape1.features();
+    const auto& features2 = shape2.features();
+    offsets.clear();
+    size_t offset = 0;
+    for (const auto& feature : features2) {
+        offsets.push_back(offset);
+        offset += feature->cubics().size();
+    }
+
+    size_t index1 = 0;
+    for (size_t i = 0; i < features1.size(); ++i) {
+        const size_t feature2 = (i + *rotation) % features2.size();
+        const auto& cubics1 = features1[i]->cubics();
+        const auto& cubics2 = features2[feature2]->cubics();
+        for (size_t j = 0; j < cubics1.size(); ++j, ++index1) {
+            const Cubic& cubic1 = cubics1[j];
+            const Cubic& cubic2 = cubics2[j];
+            const CubicSpan span1 { index1, 0.0f, 1.0f };
+            const CubicSpan span2 { offsets[feature2] + j, 0.0f, 1.0f };
+            // Sharp corners are zero length on both shapes; fold them into
+            // the previous pair like the general matcher does
+            if (cubic1.zeroLength() && cubic2.zeroLength()) {
+                if (!result.empty()) {
+                    auto& [previous1, previous2] = result.back();
+                    previous1.points()[6] = cubic1.anchor1X();
+                    previous1.points()[7] = cubic1.anchor1Y();
+                    previous2.points()[6] = cubic2.anchor1X();
+                    previous2.points()[7] = cubic2.anchor1Y();
+                    sources.back().startFold = span1;
+                    sources.back().endFold = span2;
+                }
+                continue;
+            }
+            result.emplace_back(cubic1, cubic2);
+            sources.push_back({ span1, span2, std::nullopt, std::nullopt });
+        }
+    }
+
+    return !result.empty();
+}
+
+} // anonymous namespace
+
+MorphMatcher::MorphMatcher(std::shared_ptr<const PreparedShape> start,
+    std::shared_ptr<const PreparedShape> end) {
+    reset(std::move(start), std::move(end));
+}
+
+void MorphMatcher::reset(std::shared_ptr<const PreparedShape> start,
+    std::shared_ptr<const PreparedShape> end) {
+    m_start = std::move(start);
+    m_end = std::move(end);
+    m_result.clear();
+    m_sources.clear();
+    m_mapper.reset();
+    m_cubic1.reset();
+    m_cubic2.reset();
+    m_feature = 0;
+    m_featureCubic = 0;
+    m_measures.clear();
+    m_stage = Stage::Identical;
+}
+
+bool MorphMatcher::advance(size_t steps) {
+    for (; steps > 0 && !done(); --steps) {
+        step();
+    }
+    return done();
+}
+
+bool MorphMatcher::advanceFor(std::chrono::nanoseconds budget) {
+    const auto deadline = std::chrono::steady_clock::now() + budget;
+    while (!advance(StepsPerClockCheck)) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void MorphMatcher::run() {
+    while (!done()) {
+        step();
+    }
+}
+
+void MorphMatcher::takeMatch(std::vector<std::pair<Cubic, Cubic>>& match,
+    std::vector<MatchSource>& sources) {
+    match.swap(m_result);
+    m_result.clear();
+    sources.swap(m_sources);
+    m_sources.clear();
+}
+
+Morph MorphMatcher::takeMorph() {
+    if (!done() || m_start == nullptr) {
+        throw std::logic_error("MorphMatcher has not finished matching");
+    }
+    return Morph(
+        m_start, m_end, std::move(m_result), std::move(m_sources));
+}
+
+void MorphMatcher::step() {
+    switch (m_stage) {
+    case Stage::Identical:
+        // Shapes from the same family (stars with different radii, polygons
+        // with different rounding) pair up feature by feature without
+        // measuring
+        if (matchIdentical(m_start->shape(), m_end->shape(), m_signatures1,
+                m_signatures2, m_failure, m_offsets, m_result, m_sources)) {
+            m_stage = Stage::Done;
+        } else {
+            m_result.clear();
+            m_sources.clear();
+            m_stage = Stage::MeasureStart;
+        }
+        break;
+
+    case Stage::MeasureStart:
+        // Measured polygons with progress values for each cubic, computed
+        // once per prepared shape
+        if (measure(*m_start)) {
+            m_stage = Stage::MeasureEnd;
+        }
+        break;
+
+    case Stage::MeasureEnd:
+        if (measure(*m_end)) {
+            // Map corner features between shapes
+            m_featureMapper.reset(m_start->corners(), m_end->corners());
+            m_stage = Stage::Map;
+        }
+        break;
+
+    case Stage::Map: {
+        if (!m_featureMapper.advance(MappingWorkPerStep)) {
+            break;
+        }
+        m_mapper = m_featureMapper.mapper();
+
+        // Find the cut point on polygon 2 that corresponds to progress 0 on
+        // polygon 1, and cut and rotate polygon 2 so it aligns with polygon 1
+        m_cutPoint = m_mapper->map(0.0f);
+        m_end->measured().cutAndShift(m_cutPoint, m_shifted);
+
+        const MeasuredPolygon& measured1 = m_start->measured();
+        m_index1 = 0;
+        m_index2 = 0;
+        if (m_index1 < measured1.size()) {
+            m_cubic1 = measured1[m_index1++];
+        }
+        if (m_index2 < m_shifted.size()) {
+            m_cubic2 = m_shifted[m_index2++];
+        }
+        m_stage = Stage::Cut;
+        break;
+    }
+
+    case Stage::Cut:
+        cut();
+        break;
+
+    case Stage::Done:
+        break;
+    }
+}
+
+// Measures the next few cubics of shape, and once all are measured, the
+// shape. Returns true once the shape is measured.
+bool MorphMatcher::measure(const PreparedShape& shape) {
+    if (shape.isMeasured()) {
+        // Possibly by another thread, part way through
+        m_feature = 0;
+        m_featureCubic = 0;
+        m_measures.clear();
+        return true;
+    }
+    const auto& features = shape.shape().features();
+    const Measurer& measurer = *shape.measurer();
+    size_t measured = 0;
+    while (measured < CubicsPerMeasureStep && m_feature < features.size()) {
+        const auto& cubics = features[m_feature]->cubics();
+        if (m_featureCubic == cubics.size()) {
+            ++m_feature;
+            m_featureCubic = 0;
+            continue;
+        }
+        m_measures.push_back(measurer.measureCubic(cubics[m_featureCubic++]));
+        ++measured;
+    }
+    if (m_feature < features.size()) {
+        return false;
+    }
+
+    shape.measure(m_measures);
+    m_feature = 0;
+    m_featureCubic = 0;
+    m_measures.clear();
+    return true;
+}
+
+void MorphMatcher::cut() {
+    const MeasuredPolygon& bs1 = m_start->measured();
+    const std::vector<MeasuredCubic>& bs2 = m_shifted;
+    const Measurer& measurer = *m_start->measurer();
+
+    if (!m_cubic1.has_value() || !m_cubic2.has_value()) {
+        if (m_cubic1.has_value() || m_cubic2.has_value()) {
+            throw std::runtime_error(
+                "Expected both polygon's cubics to be fully matched");
+        }
+        m_mapper.reset();
+        m_stage = Stage::Done;
+        return;
+    }
+
+    const MeasuredCubic& b1 = *m_cubic1;
+    const MeasuredCubic& b2 = *m_cubic2;
+
+    // Get end progress values (in shape1's perspective)
+    float b1a = (m_index1 == bs1.size()) ? 1.0f : b1.endOutlineProgress();
+    float b2a;
+    if (m_index2 == bs2.size()) {
+        b2a = 1.0f;
+    } else {
+        b2a = m_mapper->mapBack(
+            positiveModulo(b2.endOutlineProgress() + m_cutPoint, 1.0f));
+    }
+
+    float minb = std::min(b1a, b2a);
+
+    // Cut and get segments
+    MeasuredCubic seg1 = b1;
+    MeasuredCubic seg2 = b2;
+
+    if (b1a > minb + AngleEpsilon) {
+        auto [cut1, cut2] = b1.cutAtProgress(minb, measurer);
+        seg1 = cut1;
+        m_cubic1 = cut2;
+    } else {
+        if (m_index1 < bs1.size()) {
+            m_cubic1 = bs1[m_index1++];
+        } else {
+            m_cubic1.reset();
+        }
+    }
+
+    if (b2a > minb + AngleEpsilon) {
+        auto [cut1, cut2] = b2.cutAtProgress(
+            positiveModulo(m_mapper->map(minb) - m_cutPoint, 1.0f), measurer);
+        seg2 = cut1;
+        m_cubic2 = cut2;
+    } else {
+        if (m_index2 < bs2.size()) {
+            m_cubic2 = bs2[m_index2++];
+        } else {
+            m_cubic2.reset();
+        }
+    }
+
+    // Cuts landing within AngleEpsilon of a cubic's end can leave a sliver on
+    // both shapes. Fold those into the previous pair instead of emitting a
+    // pair that only adds work to every frame.
+    const Cubic& cubic1 = seg1.cubic();
+    const Cubic& cubic2 = seg2.cubic();
+    if (!m_result.empty() && cubic1.zeroLength() && cubic2.zeroLength()) {
+        auto& [previous1, previous2] = m_result.back();
+        previous1.points()[6] = cubic1.anchor1X();
+        previous1.points()[7] = cubic1.anchor1Y();
+        previous2.points()[6] = cubic2.anchor1X();
+        previous2.points()[7] = cubic2.anchor1Y();
+        m_sources.back().startFold = seg1.span();
+        m_sources.back().endFold = seg2.span();
+    } else {
+        m_result.emplace_back(cubic1, cubic2);
+        m_sources.push_back(
+            { seg1.span(), seg2.span(), std::nullopt, std::nullopt });
+    }
+}
+
+} // namespace RoundedPolygon
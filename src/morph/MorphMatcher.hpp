@@ -0,0 +1,143 @@
+#pragma once
+
+#include "FeatureMapping.hpp"
+#include "PolygonMeasure.hpp"
+#include "PreparedShape.hpp"
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace RoundedPolygon {
+
+class Morph;
+
+/**
+ * MatchSource records the feature cubics the two cubics of a matched pair were
+ * cut from, so that the pair can be cut again from edited shapes whose
+ * features have the same structure.
+ */
+struct MatchSource {
+    CubicSpan start;
+    CubicSpan end;
+    // Zero-length slivers folded into the pair move its end anchors to the
+    // ends of these spans
+    std::optional<CubicSpan> startFold;
+    std::optional<CubicSpan> endFold;
+};
+
+/**
+ * MorphMatcher computes the cubic pairs of a Morph in resumable steps, so
+ * that matching large shapes can be spread over several frames instead of
+ * blocking one of them.
+ *
+ * Matching goes through the same stages Morph uses: the identical-topology
+ * check, measuring each shape, mapping their features and then cutting and
+ * pairing cubics. Each step does a bounded amount of work: measuring a few
+ * cubics, measuring, sorting or trying a few candidate pairs of corners, or
+ * one cut emitting one pair. Only the identical-topology check, assembling
+ * each measured shape from its cubic measures and shifting the end shape to
+ * where matching starts run as single steps over every cubic; none of them
+ * measures anything. Measurements are cached by the prepared shapes, so
+ * measuring a shape that was matched before is free.
+ *
+ * Cancelling is just calling reset() with new shapes or dropping the
+ * matcher; its buffers are kept for the next match.
+ */
+class MorphMatcher {
+public:
+    MorphMatcher() = default;
+    MorphMatcher(std::shared_ptr<const PreparedShape> start,
+        std::shared_ptr<const PreparedShape> end);
+
+    /**
+     * Abandon the current match, if any, and start matching two other
+     * shapes.
+     */
+    void reset(std::shared_ptr<const PreparedShape> start,
+        std::shared_ptr<const PreparedShape> end);
+
+    /**
+     * Run at most steps matching steps. Returns true once matching is done.
+     */
+    bool advance(size_t steps);
+
+    /**
+     * Run matching steps until done or until budget has elapsed, checking
+     * the clock every few steps. Returns true once matching is done.
+     */
+    bool advanceFor(std::chrono::nanoseconds budget);
+
+    /**
+     * Run matching to completion.
+     */
+    void run();
+
+    [[nodiscard]] bool done() const { return m_stage == Stage::Done; }
+
+    [[nodiscard]] const std::shared_ptr<const PreparedShape>& start() const {
+        return m_start;
+    }
+
+    [[nodiscard]] const std::shared_ptr<const PreparedShape>& end() const {
+        return m_end;
+    }
+
+    /**
+     * Swap the finished match and the source of each of its pairs into match
+     * and sources, keeping their previous storage for the next run.
+     */
+    void takeMatch(std::vector<std::pair<Cubic, Cubic>>& match,
+        std::vector<MatchSource>& sources);
+
+    /**
+     * Build the morph from the finished match. Throws std::logic_error if
+     * matching is not done.
+     */
+    [[nodiscard]] Morph takeMorph();
+
+private:
+    enum class Stage { Identical, MeasureStart, MeasureEnd, Map, Cut, Done };
+
+    static constexpr size_t StepsPerClockCheck = 8;
+    // Work per step of measuring and of mapping features, each about as
+    // much as one cut
+    static constexpr size_t CubicsPerMeasureStep = 4;
+    static constexpr size_t MappingWorkPerStep = 64;
+
+    std::shared_ptr<const PreparedShape> m_start;
+    std::shared_ptr<const PreparedShape> m_end;
+    std::vector<std::pair<Cubic, Cubic>> m_result;
+    std::vector<MatchSource> m_sources;
+    Stage m_stage = Stage::Done;
+
+    // Cut stage state
+    std::optional<DoubleMapper> m_mapper;
+    float m_cutPoint = 0.0f;
+    size_t m_index1 = 0;
+    size_t m_index2 = 0;
+    std::optional<MeasuredCubic> m_cubic1;
+    std::optional<MeasuredCubic> m_cubic2;
+
+    // Measure stage state: the next cubic to measure and the measures so far
+    size_t m_feature = 0;
+    size_t m_featureCubic = 0;
+    std::vector<float> m_measures;
+
+    // Buffers kept across matches
+    IncrementalFeatureMapper m_featureMapper;
+    std::vector<MeasuredCubic> m_shifted;
+    // Kind and cubic count of each feature, and the KMP failure table used
+    // to compare them
+    std::vector<std::pair<int, size_t>> m_signatures1;
+    std::vector<std::pair<int, size_t>> m_signatures2;
+    std::vector<size_t> m_failure;
+    // Index of the first cubic of each feature of the end shape
+    std::vector<size_t> m_offsets;
+
+    void step();
+    bool measure(const PreparedShape& shape);
+    void cut();
+};
+
+} // namespace RoundedPolygon
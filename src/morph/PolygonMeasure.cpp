@@ -8,11 +8,12 @@ namespace RoundedPolygon {
 // MeasuredCubic implementation
 
 MeasuredCubic::MeasuredCubic(const Cubic& cubic, float startProgress,
-    float endProgress, float measuredSize)
+    float endProgress, float measuredSize, const CubicSpan& span)
     : m_cubic(cubic)
     , m_startOutlineProgress(startProgress)
     , m_endOutlineProgress(endProgress)
-    , m_measuredSize(measuredSize) {
+    , m_measuredSize(measuredSize)
+    , m_span(span) {
     if (endProgress < startProgress) {
         throw std::invalid_argument(
             "endOutlineProgress must be >= startOutlineProgress");
@@ -49,11 +50,13 @@ std::pair<MeasuredCubic, MeasuredCubic> MeasuredCubic::cutAtProgress(
 
     // Split the cubic
     auto [c1, c2] = m_cubic.split(t);
+    float spanT = m_span.startT + (m_span.endT - m_span.startT) * t;
 
     return { MeasuredCubic(c1, m_startOutlineProgress, boundedCutProgress,
-                 measurer.measureCubic(c1)),
+                 measurer.measureCubic(c1),
+                 { m_span.cubic, m_span.startT, spanT }),
         MeasuredCubic(c2, boundedCutProgress, m_endOutlineProgress,
-            measurer.measureCubic(c2)) };
+            measurer.measureCubic(c2), { m_span.cubic, spanT, m_span.endT }) };
 }
 
 // LengthMeasurer implementation
@@ -95,7 +98,8 @@ std::pair<float, float> LengthMeasurer::closestProgressTo(
 
 MeasuredPolygon::MeasuredPolygon(std::shared_ptr<Measurer> measurer,
     std::vector<ProgressableFeature> features, const std::vector<Cubic>& cubics,
-    const std::vector<float>& outlineProgress)
+    const std::vector<float>& outlineProgress,
+    const std::vector<CubicSpan>& spans, std::span<const float> cubicMeasures)
     : m_measurer(std::move(measurer))
     , m_features(std::move(features)) {
 
@@ -116,7 +120,7 @@ MeasuredPolygon::MeasuredPolygon(std::shared_ptr<Measurer> measurer,
         // Filter out "empty" cubics
         if ((outlineProgress[i + 1] - outlineProgress[i]) > DistanceEpsilon) {
             m_cubics.emplace_back(cubics[i], startOutlineProgress,
-                outlineProgress[i + 1], m_measurer->measureCubic(cubics[i]));
+                outlineProgress[i + 1], cubicMeasures[i], spans[i]);
             startOutlineProgress = outlineProgress[i + 1];
         }
     }
@@ -130,12 +134,41 @@ MeasuredPolygon::MeasuredPolygon(std::shared_ptr<Measurer> measurer,
     }
 }
 
+MeasuredPolygon::MeasuredPolygon(std::shared_ptr<Measurer> measurer,
+    std::vector<ProgressableFeature> features,
+    std::vector<MeasuredCubic> cubics)
+    : m_measurer(std::move(measurer))
+    , m_cubics(std::move(cubics))
+    , m_features(std::move(features)) {}
+
 MeasuredPolygon MeasuredPolygon::cutAndShift(float cuttingPoint) const {
+    std::vector<MeasuredCubic> cubics;
+    cutAndShift(cuttingPoint, cubics);
+    if (cuttingPoint < DistanceEpsilon) {
+        return *this;
+    }
+
+    // Shift features
+    std::vector<ProgressableFeature> newFeatures;
+    newFeatures.reserve(m_features.size());
+    for (const auto& feature : m_features) {
+        newFeatures.emplace_back(
+            positiveModulo(feature.progress - cuttingPoint, 1.0f),
+            feature.feature);
+    }
+    return MeasuredPolygon(
+        m_measurer, std::move(newFeatures), std::move(cubics));
+}
+
+void MeasuredPolygon::cutAndShift(
+    float cuttingPoint, std::vector<MeasuredCubic>& shifted) const {
     if (cuttingPoint < 0.0f || cuttingPoint > 1.0f) {
         throw std::invalid_argument("Cutting point must be between 0 and 1");
     }
+    shifted.clear();
     if (cuttingPoint < DistanceEpsilon) {
-        return *this;
+        shifted.assign(m_cubics.begin(), m_cubics.end());
+        return;
     }
 
     // Find the cubic to cut
@@ -148,53 +181,52 @@ MeasuredPolygon MeasuredPolygon::cutAndShift(float cuttingPoint) const {
         }
     }
 
-    const auto& target = m_cubics[targetIndex];
+    auto [b1, b2] =
+        m_cubics[targetIndex].cutAtProgress(cuttingPoint, *m_measurer);
 
-    // Cut the target cubic
-    auto [b1, b2] = target.cutAtProgress(cuttingPoint, *m_measurer);
-
-    // Build new cubics list
-    std::vector<Cubic> retCubics;
-    retCubics.push_back(b2.cubic());
+    // Filter out "empty" cubics, as the MeasuredPolygon constructor does
+    float startOutlineProgress = 0.0f;
+    auto append = [&](const MeasuredCubic& cubic, float endOutlineProgress) {
+        if (endOutlineProgress - startOutlineProgress > DistanceEpsilon) {
+            shifted.emplace_back(cubic.cubic(), startOutlineProgress,
+                endOutlineProgress, cubic.measuredSize(), cubic.span());
+            startOutlineProgress = endOutlineProgress;
+        }
+    };
 
+    append(b2,
+        positiveModulo(
+            m_cubics[targetIndex].endOutlineProgress() - cuttingPoint, 1.0f));
     for (size_t i = 1; i < m_cubics.size(); ++i) {
-        retCubics.push_back(
-            m_cubics[(i + targetIndex) % m_cubics.size()].cubic());
-    }
-    retCubics.push_back(b1.cubic());
-
-    // Build new outline progress
-    std::vector<float> retOutlineProgress;
-    retOutlineProgress.reserve(m_cubics.size() + 2);
-
-    for (size_t index = 0; index < m_cubics.size() + 2; ++index) {
-        if (index == 0) {
-            retOutlineProgress.push_back(0.0f);
-        } else if (index == m_cubics.size() + 1) {
-            retOutlineProgress.push_back(1.0f);
-        } else {
-            size_t cubicIndex = (targetIndex + index - 1) % m_cubics.size();
-            retOutlineProgress.push_back(positiveModulo(
-                m_cubics[cubicIndex].endOutlineProgress() - cuttingPoint,
-                1.0f));
-        }
+        const auto& cubic = m_cubics[(i + targetIndex) % m_cubics.size()];
+        append(cubic,
+            positiveModulo(cubic.endOutlineProgress() - cuttingPoint, 1.0f));
     }
+    append(b1, 1.0f);
 
-    // Shift features
-    std::vector<ProgressableFeature> newFeatures;
-    for (const auto& feature : m_features) {
-        newFeatures.emplace_back(
-            positiveModulo(feature.progress - cuttingPoint, 1.0f),
-            feature.feature);
+    if (shifted.empty()) {
+        throw std::runtime_error("No cubics in measured polygon");
     }
-
-    return MeasuredPolygon(
-        m_measurer, std::move(newFeatures), retCubics, retOutlineProgress);
+    shifted.back().updateProgressRange(
+        shifted.back().startOutlineProgress(), 1.0f);
 }
 
 MeasuredPolygon MeasuredPolygon::measurePolygon(
     std::shared_ptr<Measurer> measurer, const RoundedPolygonShape& polygon) {
+    std::vector<float> cubicMeasures;
+    for (const auto& feature : polygon.features()) {
+        for (const auto& cubic : feature->cubics()) {
+            cubicMeasures.push_back(measurer->measureCubic(cubic));
+        }
+    }
+    return measurePolygon(std::move(measurer), polygon, cubicMeasures);
+}
+
+MeasuredPolygon MeasuredPolygon::measurePolygon(
+    std::shared_ptr<Measurer> measurer, const RoundedPolygonShape& polygon,
+    std::span<const float> cubicMeasures) {
     std::vector<Cubic> cubics;
+    std::vector<CubicSpan> spans;
     std::vector<std::pair<const Feature*, size_t>> featureToCubic;
 
     // Get cubics from the polygon and extract features
@@ -207,15 +239,19 @@ MeasuredPolygon MeasuredPolygon::measurePolygon(
             if (corner != nullptr && cubicIndex == featureCubics.size() / 2) {
                 featureToCubic.emplace_back(feature.get(), cubics.size());
             }
+            spans.push_back({ cubics.size(), 0.0f, 1.0f });
             cubics.push_back(featureCubics[cubicIndex]);
         }
     }
+    if (cubicMeasures.size() != cubics.size()) {
+        throw std::invalid_argument(
+            "Cubic measures size must be the polygon's cubic count");
+    }
 
-    // Measure all cubics
+    // Sum up the measures of all cubics
     std::vector<float> measures;
     measures.push_back(0.0f);
-    for (const auto& cubic : cubics) {
-        float measure = measurer->measureCubic(cubic);
+    for (float measure : cubicMeasures) {
         if (measure < 0.0f) {
             throw std::runtime_error("Measured cubic must be >= 0");
         }
@@ -239,8 +275,8 @@ MeasuredPolygon MeasuredPolygon::measurePolygon(
         features.emplace_back(progress, feature);
     }
 
-    return MeasuredPolygon(
-        measurer, std::move(features), cubics, outlineProgress);
+    return MeasuredPolygon(measurer, std::move(features), cubics,
+        outlineProgress, spans, cubicMeasures);
 }
 
 } // namespace RoundedPolygon
@@ -4,6 +4,7 @@
 #include "../core/RoundedPolygon.hpp"
 #include "FloatMapping.hpp"
 #include <memory>
+#include <span>
 #include <vector>
 
 namespace RoundedPolygon {
@@ -25,6 +26,17 @@ struct ProgressableFeature {
         , feature(f) {}
 };
 
+/**
+ * CubicSpan locates a measured cubic on its polygon: the index of the feature
+ * cubic it was cut from, counting the cubics of all features in order, and
+ * the range of curve parameters of that cubic it covers.
+ */
+struct CubicSpan {
+    size_t cubic = 0;
+    float startT = 0.0f;
+    float endT = 1.0f;
+};
+
 /**
  * MeasuredCubic holds information about a cubic curve, including the
  * feature (if any) associated with it, and the outline progress values
@@ -33,10 +45,12 @@ struct ProgressableFeature {
 class MeasuredCubic {
 public:
     MeasuredCubic(const Cubic& cubic, float startProgress, float endProgress,
-        float measuredSize);
+        float measuredSize, const CubicSpan& span = {});
 
     [[nodiscard]] const Cubic& cubic() const { return m_cubic; }
 
+    [[nodiscard]] const CubicSpan& span() const { return m_span; }
+
     [[nodiscard]] float measuredSize() const { return m_measuredSize; }
 
     [[nodiscard]] float startOutlineProgress() const {
@@ -61,6 +75,7 @@ private:
     float m_startOutlineProgress;
     float m_endOutlineProgress;
     float m_measuredSize;
+    CubicSpan m_span;
 };
 
 /**
@@ -132,17 +147,37 @@ public:
      */
     [[nodiscard]] MeasuredPolygon cutAndShift(float cuttingPoint) const;
 
+    /**
+     * Writes the cubics of cutAndShift(cuttingPoint) into shifted, reusing
+     * its storage. Features are not shifted.
+     */
+    void cutAndShift(
+        float cuttingPoint, std::vector<MeasuredCubic>& shifted) const;
+
     /**
      * Create a MeasuredPolygon from a RoundedPolygon using the given measurer.
      */
     [[nodiscard]] static MeasuredPolygon measurePolygon(
         std::shared_ptr<Measurer> measurer, const RoundedPolygonShape& polygon);
 
+    /**
+     * Create a MeasuredPolygon from cubicMeasures, the measure measurer gives
+     * each cubic of the features of polygon in order, computed beforehand.
+     */
+    [[nodiscard]] static MeasuredPolygon measurePolygon(
+        std::shared_ptr<Measurer> measurer, const RoundedPolygonShape& polygon,
+        std::span<const float> cubicMeasures);
+
 private:
     MeasuredPolygon(std::shared_ptr<Measurer> measurer,
         std::vector<ProgressableFeature> features,
         const std::vector<Cubic>& cubics,
-        const std::vector<float>& outlineProgress);
+        const std::vector<float>& outlineProgress,
+        const std::vector<CubicSpan>& spans,
+        std::span<const float> cubicMeasures);
+    MeasuredPolygon(std::shared_ptr<Measurer> measurer,
+        std::vector<ProgressableFeature> features,
+        std::vector<MeasuredCubic> cubics);
 
     std::shared_ptr<Measurer> m_measurer;
     std::vector<MeasuredCubic> m_cubics;
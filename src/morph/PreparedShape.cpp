@@ -0,0 +1,105 @@
+#include "PreparedShape.hpp"
+#include <stdexcept>
+
+namespace RoundedPolygon {
+
+PreparedShape::PreparedShape(std::shared_ptr<const RoundedPolygonShape> shape)
+    : m_shape(std::move(shape))
+    , m_measurer(std::make_shared<LengthMeasurer>()) {
+    if (m_shape == nullptr) {
+        throw std::invalid_argument("PreparedShape needs a shape");
+    }
+}
+
+PreparedShape::PreparedShape(OutlineShape outline)
+    : m_outline(std::move(outline))
+    , m_measurer(std::make_shared<LengthMeasurer>()) {}
+
+std::shared_ptr<const PreparedShape> PreparedShape::prepare(
+    const RoundedPolygonShape& shape) {
+    return prepare(std::make_shared<const RoundedPolygonShape>(shape));
+}
+
+std::shared_ptr<const PreparedShape> PreparedShape::prepare(
+    std::shared_ptr<const RoundedPolygonShape> shape) {
+    return std::make_shared<const PreparedShape>(std::move(shape));
+}
+
+std::shared_ptr<const PreparedShape> PreparedShape::prepare(
+    OutlineShape outline) {
+    return std::make_shared<const PreparedShape>(std::move(outline));
+}
+
+const std::shared_ptr<const RoundedPolygonShape>&
+PreparedShape::sharedShape() const {
+    if (m_outline.has_value()) {
+        std::call_once(m_shapeOnce, [this] {
+            m_shape = std::make_shared<const RoundedPolygonShape>(
+                m_outline->shape());
+        });
+    }
+    return m_shape;
+}
+
+const std::vector<Cubic>& PreparedShape::cubics() const {
+    return m_outline.has_value() ? m_outline->cubics() : m_shape->cubics();
+}
+
+std::array<float, 4> PreparedShape::calculateBounds(bool approximate) const {
+    return m_outline.has_value() ? m_outline->calculateBounds(approximate)
+                                 : m_shape->calculateBounds(approximate);
+}
+
+std::array<float, 4> PreparedShape::calculateMaxBounds() const {
+    return m_outline.has_value() ? m_outline->calculateMaxBounds()
+                                 : m_shape->calculateMaxBounds();
+}
+
+const MeasuredPolygon& PreparedShape::measured() const {
+    measure();
+    return *m_measured;
+}
+
+const std::vector<const ProgressableFeature*>& PreparedShape::corners() const {
+    measure();
+    return m_corners;
+}
+
+const CanonicalShape& PreparedShape::canonical(size_t cubicCount) const {
+    std::lock_guard<std::mutex> lock(m_canonicalMutex);
+    for (const auto& canonical : m_canonical) {
+        if (canonical->cubicCount() == cubicCount) {
+            return *canonical;
+        }
+    }
+    m_canonical.push_back(std::make_unique<const CanonicalShape>(
+        measured(), corners(), shape(), *m_measurer, cubicCount));
+    return *m_canonical.back();
+}
+
+void PreparedShape::measure() const {
+    std::call_once(m_measureOnce, [this] {
+        setMeasured(MeasuredPolygon::measurePolygon(m_measurer, shape()));
+    });
+}
+
+void PreparedShape::measure(std::span<const float> cubicMeasures) const {
+    std::call_once(m_measureOnce, [this, cubicMeasures] {
+        setMeasured(MeasuredPolygon::measurePolygon(
+            m_measurer, shape(), cubicMeasures));
+    });
+}
+
+void PreparedShape::setMeasured(MeasuredPolygon measured) const {
+    m_measured = std::move(measured);
+
+    // Only corners take part in feature mapping
+    for (const auto& feature : m_measured->features()) {
+        if (dynamic_cast<const Corner*>(feature.feature) != nullptr) {
+            m_corners.push_back(&feature);
+        }
+    }
+    m_isMeasured.store(true, std::memory_order_release);
+}
+
+} // namespace RoundedPolygon
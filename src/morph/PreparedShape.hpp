@@ -0,0 +1,126 @@
+#pragma once
+
+#include "../core/OutlineShape.hpp"
+#include "../core/RoundedPolygon.hpp"
+#include "CanonicalShape.hpp"
+#include "PolygonMeasure.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace RoundedPolygon {
+
+/**
+ * PreparedShape bundles a RoundedPolygonShape with the data Morph needs to
+ * match it against other shapes: its measured cubics with their outline
+ * progress, and the corner features used for feature mapping.
+ *
+ * The measurement is computed the first time it is needed and then shared by
+ * every morph the shape takes part in, so a shape that is matched often (such
+ * as a resting circle) is only measured once. Prepared shapes are immutable
+ * and safe to share between threads.
+ *
+ * A shape prepared from an OutlineShape can be drawn through cubics() and
+ * calculateBounds() as it is. Its full shape, with the features morphing
+ * needs, is only built the first time shape() is called.
+ */
+class PreparedShape {
+public:
+    explicit PreparedShape(std::shared_ptr<const RoundedPolygonShape> shape);
+    explicit PreparedShape(OutlineShape outline);
+
+    PreparedShape(const PreparedShape&) = delete;
+    PreparedShape& operator=(const PreparedShape&) = delete;
+
+    [[nodiscard]] static std::shared_ptr<const PreparedShape> prepare(
+        const RoundedPolygonShape& shape);
+    [[nodiscard]] static std::shared_ptr<const PreparedShape> prepare(
+        std::shared_ptr<const RoundedPolygonShape> shape);
+    [[nodiscard]] static std::shared_ptr<const PreparedShape> prepare(
+        OutlineShape outline);
+
+    [[nodiscard]] const RoundedPolygonShape& shape() const {
+        return *sharedShape();
+    }
+
+    [[nodiscard]] const std::shared_ptr<const RoundedPolygonShape>&
+    sharedShape() const;
+
+    /**
+     * The closed outline of the shape, which does not need the full shape
+     * when prepared from an OutlineShape.
+     */
+    [[nodiscard]] const std::vector<Cubic>& cubics() const;
+
+    /**
+     * Bounds of the shape, from the outline when prepared from an
+     * OutlineShape, like cubics().
+     */
+    [[nodiscard]] std::array<float, 4> calculateBounds(
+        bool approximate = true) const;
+
+    /**
+     * The square that holds the shape in any rotation, from the outline
+     * like calculateBounds().
+     */
+    [[nodiscard]] std::array<float, 4> calculateMaxBounds() const;
+
+    [[nodiscard]] const std::shared_ptr<Measurer>& measurer() const {
+        return m_measurer;
+    }
+
+    /**
+     * The shape's cubics measured along its outline.
+     */
+    [[nodiscard]] const MeasuredPolygon& measured() const;
+
+    /**
+     * The corner features of measured(), which are the only features used
+     * for feature mapping.
+     */
+    [[nodiscard]] const std::vector<const ProgressableFeature*>&
+    corners() const;
+
+    /**
+     * The shape resampled into cubicCount cubics. Each cubic count is
+     * computed once and kept for the lifetime of the prepared shape.
+     */
+    [[nodiscard]] const CanonicalShape& canonical(
+        size_t cubicCount = CanonicalShape::DefaultCubicCount) const;
+
+private:
+    friend class MorphMatcher;
+
+    std::optional<OutlineShape> m_outline;
+    mutable std::once_flag m_shapeOnce;
+    mutable std::shared_ptr<const RoundedPolygonShape> m_shape;
+    std::shared_ptr<Measurer> m_measurer;
+
+    mutable std::once_flag m_measureOnce;
+    mutable std::atomic<bool> m_isMeasured = false;
+    mutable std::optional<MeasuredPolygon> m_measured;
+    mutable std::vector<const ProgressableFeature*> m_corners;
+
+    mutable std::mutex m_canonicalMutex;
+    mutable std::vector<std::unique_ptr<const CanonicalShape>> m_canonical;
+
+    [[nodiscard]] bool isMeasured() const {
+        return m_isMeasured.load(std::memory_order_acquire);
+    }
+
+    void measure() const;
+
+    /**
+     * Measure the shape from the measure of each cubic of its features,
+     * which MorphMatcher computes a few at a time. Does nothing if the shape
+     * was measured already.
+     */
+    void measure(std::span<const float> cubicMeasures) const;
+
+    void setMeasured(MeasuredPolygon measured) const;
+};
+
+} // namespace RoundedPolygon
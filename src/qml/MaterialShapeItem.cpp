@@ -1,29 +1,242 @@
 #include "MaterialShapeItem.hpp"
 #include "../core/RoundedPolygon.hpp"
+#include "../morph/MorphDiskCache.hpp"
+#include "../shapes/ShapeCache.hpp"
 #include "../shapes/Shapes.hpp"
 #include <QPainter>
+#include <QTimer>
 #include <QVariantMap>
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cmath>
+#include <cstring>
+#include <mutex>
 #include <numbers>
+#include <span>
+#include <unordered_map>
 
 using namespace RoundedPolygon;
 
+namespace {
+
+// Morphs whose shapes have more cubics than this in total are matched over
+// several frames, spending at most MatchFrameBudget per frame
+constexpr size_t AsyncMatchCubics = 256;
+constexpr std::chrono::milliseconds MatchFrameBudget(4);
+
+// Built-in shapes are prepared once and shared by every item, so morphing
+// to or from them only measures the other shape. Types out of range, as QML
+// may pass, give the circle like MaterialShapes::getShape.
+std::shared_ptr<const PreparedShape> preparedShape(
+    MaterialShapes::ShapeType type) {
+    struct Entry {
+        std::once_flag once;
+        std::shared_ptr<const PreparedShape> prepared;
+    };
+    static std::array<Entry, MaterialShapes::ShapeTypeCount> registry;
+
+    const auto index = static_cast<size_t>(type);
+    if (index >= MaterialShapes::ShapeTypeCount) {
+        return preparedShape(MaterialShapes::ShapeType::Circle);
+    }
+    Entry& entry = registry[index];
+    std::call_once(entry.once, [&entry, type] {
+        entry.prepared = PreparedShape::prepare(MaterialShapes::getShape(type));
+    });
+    return entry.prepared;
+}
+
+// Shapes kept for each factory function
+constexpr size_t FactoryCacheCapacity = 64;
+
+struct FactoryCaches {
+    ShapeCache<PreparedShape, int, float, float> regularPolygon{
+        FactoryCacheCapacity
+    };
+    ShapeCache<PreparedShape, int, float, float, float> star{
+        FactoryCacheCapacity
+    };
+    ShapeCache<PreparedShape, float, float, float, float> rectangle{
+        FactoryCacheCapacity
+    };
+    ShapeCache<PreparedShape, float, float> squircle{ FactoryCacheCapacity };
+};
+
+FactoryCaches& factoryCaches() {
+    static FactoryCaches caches;
+    return caches;
+}
+
+// Shapes built by polygon(), interned by the bits of the input they were
+// built from, so delegates building the same custom shape share one prepared
+// shape. Entries do not keep their shapes alive; expired ones are swept
+// whenever the table has doubled since the last sweep.
+class PolygonInterner {
+public:
+    template <typename Build>
+    std::shared_ptr<const PreparedShape> intern(
+        const std::vector<uint32_t>& key, Build&& build) {
+        const size_t hash = hashOf(key);
+        std::lock_guard lock(m_mutex);
+        auto [first, last] = m_entries.equal_range(hash);
+        for (auto it = first; it != last; ++it) {
+            if (it->second.key == key) {
+                if (auto shape = it->second.shape.lock()) {
+                    return shape;
+                }
+                m_entries.erase(it);
+                break;
+            }
+        }
+
+        std::shared_ptr<const PreparedShape> shape = build();
+        m_entries.emplace(hash, Entry{ key, shape });
+        if (m_entries.size() >= m_sweepAt) {
+            std::erase_if(m_entries,
+                [](const auto& entry) { return entry.second.shape.expired(); });
+            m_sweepAt = std::max(MinSweep, m_entries.size() * 2);
+        }
+        return shape;
+    }
+
+private:
+    static constexpr size_t MinSweep = 64;
+
+    struct Entry {
+        std::vector<uint32_t> key;
+        std::weak_ptr<const PreparedShape> shape;
+    };
+
+    std::mutex m_mutex;
+    std::unordered_multimap<size_t, Entry> m_entries;
+    size_t m_sweepAt = MinSweep;
+
+    // 64-bit FNV-1a over the key's words
+    static size_t hashOf(const std::vector<uint32_t>& key) {
+        uint64_t hash = 14695981039346656037ull;
+        for (uint32_t word : key) {
+            for (int byte = 0; byte < 4; ++byte) {
+                hash ^= (word >> (byte * 8)) & 0xffu;
+                hash *= 1099511628211ull;
+            }
+        }
+        return static_cast<size_t>(hash);
+    }
+};
+
+PolygonInterner& polygonInterner() {
+    static PolygonInterner interner;
+    return interner;
+}
+
+// Matches of morphs are kept across runs in the file named by
+// M3SHAPES_MORPH_CACHE, when it is set. Null when it is not.
+MorphDiskCache* morphDiskCache() {
+    static const std::unique_ptr<MorphDiskCache> cache =
+        []() -> std::unique_ptr<MorphDiskCache> {
+        const QString path = qEnvironmentVariable("M3SHAPES_MORPH_CACHE");
+        if (path.isEmpty()) {
+            return nullptr;
+        }
+        return std::make_unique<MorphDiskCache>(path.toStdString());
+    }();
+    return cache.get();
+}
+
+// Values per vertex in the interleaved input of the polygon factories
+constexpr qsizetype VertexStride = 4;
+
+// The normalized custom polygon with the vertices given as interleaved x, y,
+// radius and smoothing values, shared with every polygon built from the same
+// input
+std::shared_ptr<const PreparedShape> internedPolygon(
+    std::span<const float> values, int reps, float centerX, float centerY,
+    bool mirroring) {
+    std::vector<uint32_t> key;
+    key.reserve(values.size() + 4);
+    for (float value : values) {
+        key.push_back(std::bit_cast<uint32_t>(value));
+    }
+    key.push_back(static_cast<uint32_t>(reps));
+    key.push_back(std::bit_cast<uint32_t>(centerX));
+    key.push_back(std::bit_cast<uint32_t>(centerY));
+    key.push_back(mirroring ? 1u : 0u);
+
+    return polygonInterner().intern(key, [&] {
+        std::vector<MaterialShapes::PointNRound> points;
+        points.reserve(values.size() / VertexStride);
+        for (size_t i = 0; i + VertexStride <= values.size();
+             i += VertexStride) {
+            points.emplace_back(values[i], values[i + 1],
+                CornerRounding(values[i + 2], values[i + 3]));
+        }
+        return PreparedShape::prepare(MaterialShapes::customPolygon(
+            points, reps, centerX, centerY, mirroring)
+                .normalized());
+    });
+}
+
+// Maps the unit square shapes are normalized to onto the largest square
+// centered in an item, turned by rotation radians around its center
+class ItemTransform {
+public:
+    ItemTransform(float itemWidth, float itemHeight, float rotation)
+        : m_size(std::min(itemWidth, itemHeight))
+        , m_centerX(itemWidth / 2.0f)
+        , m_centerY(itemHeight / 2.0f)
+        , m_cos(std::cos(rotation))
+        , m_sin(std::sin(rotation)) {}
+
+    [[nodiscard]] QPointF map(float px, float py) const {
+        float dx = px - 0.5f;
+        float dy = py - 0.5f;
+        float x = m_centerX + (dx * m_cos - dy * m_sin) * m_size;
+        float y = m_centerY + (dx * m_sin + dy * m_cos) * m_size;
+        return QPointF(static_cast<qreal>(x), static_cast<qreal>(y));
+    }
+
+private:
+    float m_size;
+    float m_centerX;
+    float m_centerY;
+    float m_cos;
+    float m_sin;
+};
+
+} // anonymous namespace
+
 // ========== RoundedPolygonWrapper ==========
 
 RoundedPolygonWrapper::RoundedPolygonWrapper(const RoundedPolygonShape& shape)
-    : m_shape(shape) {}
+    : m_prepared(PreparedShape::prepare(shape)) {}
+
+RoundedPolygonWrapper::RoundedPolygonWrapper(OutlineShape outline)
+    : m_prepared(PreparedShape::prepare(std::move(outline))) {}
+
+RoundedPolygonWrapper::RoundedPolygonWrapper(
+    std::shared_ptr<const PreparedShape> prepared)
+    : m_prepared(std::move(prepared)) {}
 
 const RoundedPolygonShape& RoundedPolygonWrapper::shape() const {
-    static RoundedPolygonShape defaultShape =
-        MaterialShapes::getShape(MaterialShapes::ShapeType::Circle);
-    return m_shape.has_value() ? *m_shape : defaultShape;
+    if (m_prepared != nullptr) {
+        return m_prepared->shape();
+    }
+    return preparedShape(MaterialShapes::ShapeType::Circle)->shape();
 }
 
 RoundedPolygonWrapper RoundedPolygonWrapper::normalized() const {
-    if (!m_shape.has_value()) {
+    if (m_prepared == nullptr) {
         return {};
     }
-    return RoundedPolygonWrapper(m_shape->normalized());
+    return RoundedPolygonWrapper(m_prepared->shape().normalized());
+}
+
+RoundedPolygonWrapper RoundedPolygonWrapper::simplified(float maxError) const {
+    if (m_prepared == nullptr) {
+        return {};
+    }
+    return RoundedPolygonWrapper(m_prepared->shape().simplified(maxError));
 }
 
 // ========== MaterialShapeItem ==========
@@ -50,10 +263,8 @@ MaterialShapeItem::MaterialShapeItem(QQuickItem* parent)
     connect(m_animation, &QPropertyAnimation::finished, this,
         &MaterialShapeItem::onMorphFinished);
 
-    // Initialize with circle shape
-    auto circleShape =
-        MaterialShapes::getShape(MaterialShapes::ShapeType::Circle);
-    m_morph = std::make_unique<Morph>(circleShape, circleShape);
+    // Rest on a circle; a morph is only built once a transition starts
+    buildMorph(Circle, Circle);
 }
 
 // ========== Factory functions ==========
@@ -74,8 +285,8 @@ RoundedPolygonWrapper MaterialShapeItem::polygon(const QVariantList& vertices,
         return {};
     }
 
-    std::vector<MaterialShapes::PointNRound> points;
-    points.reserve(static_cast<size_t>(vertices.size()));
+    std::vector<float> values;
+    values.reserve(static_cast<size_t>(vertices.size()) * VertexStride);
 
     for (const QVariant& vertex : vertices) {
         float x = 0.0f, y = 0.0f;
@@ -100,12 +311,39 @@ RoundedPolygonWrapper MaterialShapeItem::polygon(const QVariantList& vertices,
             }
         }
 
-        points.emplace_back(x, y, CornerRounding(radius, smoothing));
+        values.insert(values.end(), { x, y, radius, smoothing });
     }
 
     return RoundedPolygonWrapper(
-        MaterialShapes::customPolygon(points, reps, centerX, centerY, mirroring)
-            .normalized());
+        internedPolygon(values, reps, centerX, centerY, mirroring));
+}
+
+RoundedPolygonWrapper MaterialShapeItem::polygonFromArray(
+    const QList<float>& values, int reps, float centerX, float centerY,
+    bool mirroring) {
+    if (values.isEmpty() || values.size() % VertexStride != 0) {
+        return {};
+    }
+    return RoundedPolygonWrapper(internedPolygon(
+        std::span<const float>(values.constData(),
+            static_cast<size_t>(values.size())),
+        reps, centerX, centerY, mirroring));
+}
+
+RoundedPolygonWrapper MaterialShapeItem::polygonFromBuffer(
+    const QByteArray& buffer, int reps, float centerX, float centerY,
+    bool mirroring) {
+    constexpr qsizetype vertexBytes = sizeof(float) * VertexStride;
+    if (buffer.isEmpty() || buffer.size() % vertexBytes != 0) {
+        return {};
+    }
+    // Copied out, since the buffer's bytes need not be aligned for floats
+    std::vector<float> values(static_cast<size_t>(buffer.size()) /
+        sizeof(float));
+    std::memcpy(values.data(), buffer.constData(),
+        static_cast<size_t>(buffer.size()));
+    return RoundedPolygonWrapper(
+        internedPolygon(values, reps, centerX, centerY, mirroring));
 }
 
 RoundedPolygonWrapper MaterialShapeItem::regularPolygon(
@@ -113,9 +351,13 @@ RoundedPolygonWrapper MaterialShapeItem::regularPolygon(
     if (numVertices < 3) {
         numVertices = 3;
     }
-    return RoundedPolygonWrapper(RoundedPolygonShape(
-        numVertices, 1.0f, 0.0f, 0.0f, CornerRounding(radius, smoothing))
-            .normalized());
+    return RoundedPolygonWrapper(factoryCaches().regularPolygon.get(
+        [](int vertices, float cornerRadius, float cornerSmoothing) {
+            return PreparedShape::prepare(OutlineShape(vertices, 1.0f, 0.0f,
+                0.0f, CornerRounding(cornerRadius, cornerSmoothing))
+                    .normalized());
+        },
+        numVertices, radius, smoothing));
 }
 
 RoundedPolygonWrapper MaterialShapeItem::star(
@@ -123,51 +365,56 @@ RoundedPolygonWrapper MaterialShapeItem::star(
     if (points < 2) {
         points = 2;
     }
-    return RoundedPolygonWrapper(Shapes::star(
-        points, 1.0f, innerRadius, CornerRounding(radius, smoothing))
-            .normalized());
+    return RoundedPolygonWrapper(factoryCaches().star.get(
+        [](int numPoints, float inner, float cornerRadius,
+            float cornerSmoothing) {
+            return PreparedShape::prepare(Shapes::star(numPoints, 1.0f, inner,
+                CornerRounding(cornerRadius, cornerSmoothing))
+                    .normalized());
+        },
+        points, innerRadius, radius, smoothing));
 }
 
 RoundedPolygonWrapper MaterialShapeItem::rectangle(
     float width, float height, float radius, float smoothing) {
-    return RoundedPolygonWrapper(
-        Shapes::rectangle(width, height, CornerRounding(radius, smoothing))
-            .normalized());
+    return RoundedPolygonWrapper(factoryCaches().rectangle.get(
+        [](float w, float h, float cornerRadius, float cornerSmoothing) {
+            return PreparedShape::prepare(Shapes::rectangle(w, h,
+                CornerRounding(cornerRadius, cornerSmoothing))
+                    .normalized());
+        },
+        width, height, radius, smoothing));
 }
 
 RoundedPolygonWrapper MaterialShapeItem::squircle(float n, int segments) {
     if (n < 0.1f) {
         n = 0.1f;
     }
-    if (segments < 4) {
-        segments = 4;
-    }
-
-    std::vector<float> vertices;
-    vertices.reserve(static_cast<size_t>(segments) * 2);
-
-    const float exp = 2.0f / n;
-    const float pi2 = static_cast<float>(std::numbers::pi) * 2.0f;
-
-    for (int i = 0; i < segments; ++i) {
-        float t = pi2 * static_cast<float>(i) / static_cast<float>(segments);
-        float cosT = std::cos(t);
-        float sinT = std::sin(t);
-
-        // Superellipse: |x|^n + |y|^n = 1
-        // Parametric: x = sign(cos(t)) * |cos(t)|^(2/n)
-        //             y = sign(sin(t)) * |sin(t)|^(2/n)
-        float x = std::copysign(std::pow(std::abs(cosT), exp), cosT);
-        float y = std::copysign(std::pow(std::abs(sinT), exp), sinT);
+    // As close to the curve as a polygon of that many sides is to a circle
+    // of the same size
+    const float maxError = 0.5f *
+        (1.0f - std::cos(FloatPi / static_cast<float>(std::max(segments, 4))));
+    return RoundedPolygonWrapper(factoryCaches().squircle.get(
+        [](float exponent, float tolerance) {
+            return PreparedShape::prepare(Shapes::superellipse(exponent, 0.5f,
+                0.5f, tolerance, 0.5f, 0.5f)
+                    .normalized());
+        },
+        n, maxError));
+}
 
-        // Scale to 0-1 range (centered at 0.5)
-        vertices.push_back(x * 0.5f + 0.5f);
-        vertices.push_back(y * 0.5f + 0.5f);
-    }
+QVariantMap MaterialShapeItem::factoryCacheStats() {
+    FactoryCaches& caches = factoryCaches();
+    ShapeCacheStats stats = caches.regularPolygon.stats();
+    stats += caches.star.stats();
+    stats += caches.rectangle.stats();
+    stats += caches.squircle.stats();
 
-    // No corner rounding needed - the curve itself is smooth
-    return RoundedPolygonWrapper(
-        RoundedPolygonShape(vertices, CornerRounding::Unrounded).normalized());
+    QVariantMap map;
+    map["hits"] = static_cast<qulonglong>(stats.hits);
+    map["misses"] = static_cast<qulonglong>(stats.misses);
+    map["size"] = static_cast<qulonglong>(stats.size);
+    return map;
 }
 
 // ========== Property setters ==========
@@ -186,9 +433,9 @@ void MaterialShapeItem::setShape(Shape shape) {
             m_currentShape = shape;
             m_fromShape = shape;
             m_toShape = shape;
-            auto targetShape = getShapeForEnum(shape);
-            m_morph = std::make_unique<Morph>(targetShape, targetShape);
+            buildMorph(shape, shape);
             m_morphProgress = 1.0f;
+            clearBakedMorph();
             return;
         }
 
@@ -201,6 +448,7 @@ void MaterialShapeItem::setAnimationDuration(int duration) {
     if (m_animationDuration != duration) {
         m_animationDuration = duration;
         m_animation->setDuration(duration);
+        updateLoopDuration();
         emit animationDurationChanged();
     }
 }
@@ -209,7 +457,9 @@ void MaterialShapeItem::setAnimationEasing(const QEasingCurve& easing) {
     if (m_animationEasing != easing) {
         m_animationEasing = easing;
         m_animation->setEasingCurve(easing);
+        clearBakedMorph();
         emit animationEasingChanged();
+        invalidatePath();
     }
 }
 
@@ -230,7 +480,7 @@ void MaterialShapeItem::setToShape(Shape shape) {
 }
 
 void MaterialShapeItem::setCustomShape(const RoundedPolygonWrapper& shape) {
-    if (!shape.isValid()) {
+    if (!shape.isValid() || shape == m_customShape) {
         return;
     }
 
@@ -240,7 +490,7 @@ void MaterialShapeItem::setCustomShape(const RoundedPolygonWrapper& shape) {
     // Only rebuild morph if shape is already Custom
     if (m_targetShape == Custom) {
         if (!isComponentComplete()) {
-            m_morph = std::make_unique<Morph>(shape.shape(), shape.shape());
+            m_restingShape = shape.prepared();
             m_morphProgress = 1.0f;
         } else {
             rebuildMorph();
@@ -250,7 +500,8 @@ void MaterialShapeItem::setCustomShape(const RoundedPolygonWrapper& shape) {
 }
 
 void MaterialShapeItem::setCustomFromShape(const RoundedPolygonWrapper& shape) {
-    if (!shape.isValid()) {
+    if (!shape.isValid() ||
+        (shape == m_customFromShape && m_fromShape == Custom)) {
         return;
     }
     m_customFromShape = shape;
@@ -261,7 +512,8 @@ void MaterialShapeItem::setCustomFromShape(const RoundedPolygonWrapper& shape) {
 }
 
 void MaterialShapeItem::setCustomToShape(const RoundedPolygonWrapper& shape) {
-    if (!shape.isValid()) {
+    if (!shape.isValid() ||
+        (shape == m_customToShape && m_toShape == Custom)) {
         return;
     }
     m_customToShape = shape;
@@ -276,9 +528,8 @@ void MaterialShapeItem::rebuildMorph() {
         m_pendingRebuild = true;
         return;
     }
-    RoundedPolygonShape from = getShapeForEnum(m_fromShape);
-    RoundedPolygonShape to = getShapeForEnum(m_toShape);
-    m_morph = std::make_unique<Morph>(from, to);
+    buildMorph(m_fromShape, m_toShape);
+    clearBakedMorph();
     invalidatePath();
 }
 
@@ -296,23 +547,23 @@ void MaterialShapeItem::endBatchUpdate() {
     }
 }
 
-RoundedPolygonShape MaterialShapeItem::getShapeForEnum(Shape shape) const {
+std::shared_ptr<const PreparedShape> MaterialShapeItem::getShapeForEnum(
+    Shape shape) const {
     if (shape == Custom) {
         // Check which custom shape to use based on context
         if (m_customToShape.isValid() && shape == m_toShape) {
-            return m_customToShape.shape();
+            return m_customToShape.prepared();
         }
         if (m_customFromShape.isValid() && shape == m_fromShape) {
-            return m_customFromShape.shape();
+            return m_customFromShape.prepared();
         }
         if (m_customShape.isValid()) {
-            return m_customShape.shape();
+            return m_customShape.prepared();
         }
         // Fallback to circle
-        return MaterialShapes::getShape(MaterialShapes::ShapeType::Circle);
+        return preparedShape(MaterialShapes::ShapeType::Circle);
     }
-    return MaterialShapes::getShape(
-        static_cast<MaterialShapes::ShapeType>(shape));
+    return preparedShape(static_cast<MaterialShapes::ShapeType>(shape));
 }
 
 void MaterialShapeItem::startMorph(Shape from, Shape to) {
@@ -322,22 +573,258 @@ void MaterialShapeItem::startMorph(Shape from, Shape to) {
     emit fromShapeChanged();
     emit toShapeChanged();
 
-    auto fromShape = getShapeForEnum(from);
-    auto toShape = getShapeForEnum(to);
+    if (buildMorph(from, to)) {
+        m_morphProgress = 0.0f;
+        bakeMorph(from, to);
+        m_animation->start();
+    } else {
+        m_animateWhenMatched = true;
+    }
 
-    m_morph = std::make_unique<Morph>(fromShape, toShape);
-    m_morphProgress = 0.0f;
+    invalidatePath();
+}
 
-    m_animation->start();
+bool MaterialShapeItem::buildMorph(Shape from, Shape to) {
+    // A new target cancels a match still in progress
+    m_matchPending = false;
+    m_animateWhenMatched = false;
+
+    auto start = getShapeForEnum(from);
+    auto end = getShapeForEnum(to);
+    if (start == end) {
+        // Nothing to morph: paint the shape itself until a transition starts
+        m_restingShape = std::move(start);
+        return true;
+    }
 
+    // Built-in shapes never change, so a morph between them can be kept for
+    // a repeated transition or run backwards when a toggle flips, without
+    // matching the shapes again
+    const bool builtIn = from != Custom && to != Custom;
+    if (m_morph != nullptr && builtIn &&
+        m_morphCanonicalCubics == m_canonicalCubics) {
+        if (m_morphFrom == from && m_morphTo == to) {
+            m_restingShape.reset();
+            return true;
+        }
+        if (m_morphFrom == to && m_morphTo == from) {
+            m_morph = std::make_unique<Morph>(m_morph->reversed());
+            m_morphFrom = from;
+            m_morphTo = to;
+            m_restingShape.reset();
+            return true;
+        }
+    }
+
+    // A custom shape driven by an editor usually keeps its features between
+    // edits, so the current match is cut again from the edited shape
+    // instead of matching the shapes from scratch
+    if (m_morph != nullptr && !builtIn && m_morphFrom == from &&
+        m_morphTo == to && m_canonicalCubics == 0 &&
+        m_morph->update(start, end)) {
+        m_restingShape.reset();
+        return true;
+    }
+
+    MorphDiskCache* diskCache =
+        m_canonicalCubics == 0 ? morphDiskCache() : nullptr;
+    if (diskCache != nullptr) {
+        if (auto cached = diskCache->find(start, end)) {
+            m_morph = std::make_unique<Morph>(std::move(*cached));
+            m_morphFrom = from;
+            m_morphTo = to;
+            m_morphCanonicalCubics = 0;
+            m_restingShape.reset();
+            return true;
+        }
+    }
+
+    const size_t cubics =
+        start->cubics().size() + end->cubics().size();
+    if (m_canonicalCubics == 0 && isComponentComplete() &&
+        cubics > AsyncMatchCubics) {
+        if (m_matcher == nullptr) {
+            m_matcher = std::make_unique<MorphMatcher>();
+        }
+        m_matcher->reset(std::move(start), std::move(end));
+        m_matchFrom = from;
+        m_matchTo = to;
+        m_matchPending = true;
+        polish();
+        return false;
+    }
+
+    if (m_canonicalCubics > 0) {
+        m_morph = std::make_unique<Morph>(Morph::canonical(std::move(start),
+            std::move(end), static_cast<size_t>(m_canonicalCubics)));
+    } else if (m_morph != nullptr) {
+        // Rapid retargeting keeps reusing the same match buffers
+        m_morph->reset(std::move(start), std::move(end));
+    } else {
+        m_morph = std::make_unique<Morph>(std::move(start), std::move(end));
+    }
+    if (diskCache != nullptr) {
+        diskCache->insert(*m_morph);
+    }
+    m_morphFrom = from;
+    m_morphTo = to;
+    m_morphCanonicalCubics = m_canonicalCubics;
+    m_restingShape.reset();
+    return true;
+}
+
+void MaterialShapeItem::bakeMorph(Shape from, Shape to) {
+    m_bakedFrame = -1;
+    if (m_bakedFrames < 2 || m_restingShape != nullptr) {
+        clearBakedMorph();
+        return;
+    }
+
+    // Replaying the same built-in transition keeps its frames and paths
+    if (m_bakedMorph != nullptr && m_bakedFrom == from && m_bakedTo == to &&
+        from != Custom && to != Custom) {
+        return;
+    }
+
+    const QEasingCurve easing = m_animationEasing;
+    m_bakedMorph = std::make_unique<BakedMorph>(*m_morph,
+        static_cast<size_t>(m_bakedFrames), [easing](float fraction) {
+            return static_cast<float>(
+                easing.valueForProgress(static_cast<qreal>(fraction)));
+        });
+    m_bakedFrom = from;
+    m_bakedTo = to;
+    m_bakedPaths.assign(m_bakedMorph->frameCount(), QPainterPath());
+}
+
+void MaterialShapeItem::clearBakedMorph() {
+    m_bakedMorph.reset();
+    m_bakedPaths.clear();
+    m_bakedFrame = -1;
+}
+
+void MaterialShapeItem::setBakedFrames(int frames) {
+    frames = std::max(frames, 0);
+    if (m_bakedFrames != frames) {
+        m_bakedFrames = frames;
+        clearBakedMorph();
+        emit bakedFramesChanged();
+        invalidatePath();
+    }
+}
+
+void MaterialShapeItem::setLoopShapes(const QVariantList& shapes) {
+    if (m_loopShapes == shapes) {
+        return;
+    }
+    m_loopShapes = shapes;
+
+    m_loopMorphs.clear();
+    if (shapes.size() >= 2) {
+        m_loopMorphs.reserve(static_cast<size_t>(shapes.size()));
+        for (qsizetype i = 0; i < shapes.size(); ++i) {
+            const QVariant& next = shapes[(i + 1) % shapes.size()];
+            m_loopMorphs.emplace_back(
+                getShapeForEnum(static_cast<Shape>(shapes[i].toInt())),
+                getShapeForEnum(static_cast<Shape>(next.toInt())));
+        }
+    }
+
+    if (m_loopMorphs.empty()) {
+        if (m_loopAnimation != nullptr) {
+            m_loopAnimation->stop();
+        }
+        m_frameCubics.clear();
+    } else {
+        if (m_loopAnimation == nullptr) {
+            m_loopAnimation = new QVariantAnimation(this);
+            m_loopAnimation->setStartValue(0.0f);
+            m_loopAnimation->setLoopCount(-1);
+            connect(m_loopAnimation, &QVariantAnimation::valueChanged, this,
+                &MaterialShapeItem::onLoopValueChanged);
+        }
+        m_loopAnimation->stop();
+        m_loopAnimation->setEndValue(static_cast<float>(m_loopMorphs.size()));
+        updateLoopDuration();
+        m_loopPhase = 0.0f;
+        m_loopLap = 0;
+        m_loopLapDegrees = 0.0f;
+        m_loopAnimation->start();
+    }
+
+    emit loopShapesChanged();
     invalidatePath();
 }
 
+void MaterialShapeItem::setLoopRotation(float degrees) {
+    if (!qFuzzyCompare(m_loopRotation, degrees)) {
+        m_loopRotation = degrees;
+        emit loopRotationChanged();
+        invalidatePath();
+    }
+}
+
+void MaterialShapeItem::updateLoopDuration() {
+    if (m_loopAnimation != nullptr && !m_loopMorphs.empty()) {
+        m_loopAnimation->setDuration(m_animationDuration *
+                                     static_cast<int>(m_loopMorphs.size()));
+    }
+}
+
+void MaterialShapeItem::onLoopValueChanged(const QVariant& value) {
+    // The phase wraps back to 0 at the end of each lap, so the turns of
+    // completed laps are counted here to keep the rotation continuous
+    const int lap = m_loopAnimation->currentLoop();
+    if (lap != m_loopLap) {
+        const float steps = static_cast<float>(m_loopMorphs.size());
+        m_loopLapDegrees = std::fmod(m_loopLapDegrees +
+            static_cast<float>(lap - m_loopLap) * steps * m_loopRotation,
+            360.0f);
+        m_loopLap = lap;
+    }
+    m_loopPhase = value.toFloat();
+    invalidatePath();
+}
+
+void MaterialShapeItem::setCanonicalCubics(int cubics) {
+    cubics = std::max(cubics, 0);
+    if (m_canonicalCubics != cubics) {
+        m_canonicalCubics = cubics;
+        emit canonicalCubicsChanged();
+        rebuildMorph();
+    }
+}
+
 void MaterialShapeItem::onAnimationValueChanged(const QVariant& value) {
-    setMorphProgress(value.toFloat());
+    if (m_bakedMorph != nullptr) {
+        // Frames are baked along the animation timeline, so look them up by
+        // elapsed time rather than by the eased value
+        const int duration = m_animation->duration();
+        const float fraction = duration > 0
+                                   ? static_cast<float>(
+                                         m_animation->currentTime()) /
+                                         static_cast<float>(duration)
+                                   : 1.0f;
+        const int frame = static_cast<int>(m_bakedMorph->frameIndex(fraction));
+        if (frame != m_bakedFrame) {
+            m_bakedFrame = frame;
+            invalidatePath();
+        }
+    }
+    updateMorphProgress(value.toFloat());
 }
 
 void MaterialShapeItem::setMorphProgress(float progress) {
+    // Progress set from outside the animation is not on the baked timeline
+    if (m_bakedFrame >= 0 &&
+        m_animation->state() != QAbstractAnimation::Running) {
+        m_bakedFrame = -1;
+        invalidatePath();
+    }
+    updateMorphProgress(progress);
+}
+
+void MaterialShapeItem::updateMorphProgress(float progress) {
     if (!qFuzzyCompare(m_morphProgress, progress)) {
         m_morphProgress = progress;
         emit morphProgressChanged();
@@ -349,6 +836,10 @@ void MaterialShapeItem::onMorphFinished() {
     m_currentShape = m_targetShape;
     m_fromShape = m_targetShape;
     m_morphProgress = 1.0f;
+    // The transition is over; paint its end shape without interpolating
+    if (m_restingShape == nullptr && m_morph != nullptr) {
+        m_restingShape = m_morph->end();
+    }
     emit fromShapeChanged();
     update();
 }
@@ -386,47 +877,129 @@ void MaterialShapeItem::setStrokeWidth(float width) {
     }
 }
 
-QPainterPath MaterialShapeItem::buildPath() const {
-    QPainterPath path;
+const std::vector<Cubic>& MaterialShapeItem::frameCubics(
+    float& rotation) const {
+    rotation = 0.0f;
+    if (!m_loopMorphs.empty()) {
+        const size_t steps = m_loopMorphs.size();
+        const float phase = std::clamp(
+            m_loopPhase, 0.0f, static_cast<float>(steps) - 1e-4f);
+        const auto step = static_cast<size_t>(phase);
+        const float fraction = phase - static_cast<float>(step);
+        const auto progress = static_cast<float>(
+            m_animationEasing.valueForProgress(static_cast<qreal>(fraction)));
+
+        m_frameCubics.clear();
+        m_loopMorphs[step].forEachCubic(
+            progress, [this](const MutableCubic& cubic) {
+                m_frameCubics.push_back(cubic);
+            });
+        const float degrees = m_loopLapDegrees + m_loopRotation * m_loopPhase;
+        rotation = degrees * std::numbers::pi_v<float> / 180.0f;
+        return m_frameCubics;
+    }
 
-    if (m_morph == nullptr) {
-        return path;
+    if (m_bakedMorph != nullptr && m_bakedFrame >= 0) {
+        m_bakedMorph->frame(static_cast<size_t>(m_bakedFrame), m_frameCubics);
+        return m_frameCubics;
+    }
+
+    if (m_restingShape != nullptr) {
+        return m_restingShape->cubics();
+    }
+
+    m_frameCubics.clear();
+    if (m_morph != nullptr) {
+        m_morph->forEachCubic(m_morphProgress,
+            [this](const MutableCubic& cubic) {
+                m_frameCubics.push_back(cubic);
+            });
     }
+    return m_frameCubics;
+}
+
+QPainterPath MaterialShapeItem::buildPath() const {
+    if (m_loopMorphs.empty() && m_bakedMorph != nullptr && m_bakedFrame >= 0) {
+        const auto frame = static_cast<size_t>(m_bakedFrame);
+        QPainterPath& bakedPath = m_bakedPaths[frame];
+        if (bakedPath.isEmpty()) {
+            bakedPath = pathFromCubics(m_bakedMorph->frame(frame));
+        }
+        return bakedPath;
+    }
+
+    float rotation = 0.0f;
+    const std::vector<Cubic>& cubics = frameCubics(rotation);
+    return pathFromCubics(cubics, rotation);
+}
 
-    auto cubics = m_morph->asCubics(m_morphProgress);
+QPainterPath MaterialShapeItem::pathFromCubics(
+    const std::vector<Cubic>& cubics, float rotation) const {
+    QPainterPath path;
 
     if (cubics.empty()) {
         return path;
     }
 
-    float itemWidth = static_cast<float>(width());
-    float itemHeight = static_cast<float>(height());
-    float size = std::min(itemWidth, itemHeight);
-    float cX = itemWidth / 2.0f;
-    float cY = itemHeight / 2.0f;
-
-    auto transformPoint = [&](float px, float py) -> QPointF {
-        float x = cX + (px - 0.5f) * size;
-        float y = cY + (py - 0.5f) * size;
-        return QPointF(static_cast<qreal>(x), static_cast<qreal>(y));
-    };
+    const ItemTransform transform(static_cast<float>(width()),
+        static_cast<float>(height()), rotation);
 
     // Build path from cubics (like Android's toPath())
     bool first = true;
     for (const auto& cubic : cubics) {
         if (first) {
-            path.moveTo(transformPoint(cubic.anchor0X(), cubic.anchor0Y()));
+            path.moveTo(transform.map(cubic.anchor0X(), cubic.anchor0Y()));
             first = false;
         }
-        path.cubicTo(transformPoint(cubic.control0X(), cubic.control0Y()),
-            transformPoint(cubic.control1X(), cubic.control1Y()),
-            transformPoint(cubic.anchor1X(), cubic.anchor1Y()));
+        path.cubicTo(transform.map(cubic.control0X(), cubic.control0Y()),
+            transform.map(cubic.control1X(), cubic.control1Y()),
+            transform.map(cubic.anchor1X(), cubic.anchor1Y()));
     }
     path.closeSubpath();
 
     return path;
 }
 
+QByteArray MaterialShapeItem::cubicData() const {
+    if (!m_cubicDataDirty) {
+        return m_cubicData;
+    }
+    m_cubicDataDirty = false;
+    if (width() <= 0 || height() <= 0) {
+        m_cubicData.clear();
+        return m_cubicData;
+    }
+
+    float rotation = 0.0f;
+    const std::vector<Cubic>& cubics = frameCubics(rotation);
+    const ItemTransform transform(static_cast<float>(width()),
+        static_cast<float>(height()), rotation);
+
+    // Written in place, allocating only when the frame has more cubics. While
+    // the previous frame's data is still referenced, resize() would copy it
+    // to a buffer about to be overwritten, so take a fresh one instead.
+    constexpr size_t cubicBytes = sizeof(float) * 8;
+    const auto size = static_cast<qsizetype>(cubics.size() * cubicBytes);
+    if (m_cubicData.isDetached()) {
+        m_cubicData.resize(size);
+    } else {
+        m_cubicData = QByteArray(size, Qt::Uninitialized);
+    }
+    char* out = m_cubicData.data();
+    for (const auto& cubic : cubics) {
+        std::array<float, 8> points;
+        for (size_t i = 0; i < 4; ++i) {
+            const QPointF point = transform.map(
+                cubic.points()[i * 2], cubic.points()[i * 2 + 1]);
+            points[i * 2] = static_cast<float>(point.x());
+            points[i * 2 + 1] = static_cast<float>(point.y());
+        }
+        std::memcpy(out, points.data(), cubicBytes);
+        out += cubicBytes;
+    }
+    return m_cubicData;
+}
+
 const QPainterPath& MaterialShapeItem::cachedPath() const {
     if (m_pathDirty) {
         m_cachedPath = buildPath();
@@ -444,10 +1017,86 @@ const QList<QPolygonF>& MaterialShapeItem::cachedPolygons() const {
     return m_cachedPolygons;
 }
 
+QRectF MaterialShapeItem::shapeToItemRect(
+    const std::array<float, 4>& bounds) const {
+    const qreal size = std::min(width(), height());
+    const qreal cX = width() / 2.0;
+    const qreal cY = height() / 2.0;
+    return QRectF(
+        QPointF(cX + (static_cast<qreal>(bounds[0]) - 0.5) * size,
+            cY + (static_cast<qreal>(bounds[1]) - 0.5) * size),
+        QPointF(cX + (static_cast<qreal>(bounds[2]) - 0.5) * size,
+            cY + (static_cast<qreal>(bounds[3]) - 0.5) * size));
+}
+
+QRectF MaterialShapeItem::currentShapeRect() const {
+    if (width() <= 0 || height() <= 0 || !m_loopMorphs.empty()) {
+        // Looping shapes turn, so repaint the whole item
+        return {};
+    }
+    if (m_bakedMorph != nullptr && m_bakedFrame >= 0) {
+        // Baked frame paths are cached, so their control points are cheap
+        return cachedPath().controlPointRect();
+    }
+    if (m_restingShape != nullptr) {
+        return shapeToItemRect(m_restingShape->calculateBounds());
+    }
+    if (m_morph == nullptr) {
+        return {};
+    }
+    return shapeToItemRect(m_morph->boundsAt(m_morphProgress));
+}
+
 void MaterialShapeItem::invalidatePath() {
     m_pathDirty = true;
     m_polygonsDirty = true;
-    update();
+    m_cubicDataDirty = true;
+
+    // Repaint only the area covered by the shape before and after the
+    // change, which also follows overshooting easings outside the start and
+    // end shapes
+    const QRectF shapeRect = currentShapeRect();
+    if (shapeRect.isNull() || m_paintedRect.isNull()) {
+        m_paintedRect = shapeRect;
+        update();
+        return;
+    }
+
+    // Leave room for the stroke and antialiasing
+    const qreal margin = static_cast<qreal>(m_strokeWidth) / 2.0 + 1.0;
+    const QRectF dirtyRect = shapeRect.united(m_paintedRect)
+                                 .adjusted(-margin, -margin, margin, margin);
+    m_paintedRect = shapeRect;
+    update(dirtyRect.toAlignedRect());
+}
+
+void MaterialShapeItem::updatePolish() {
+    if (!m_matchPending) {
+        return;
+    }
+    if (!m_matcher->advanceFor(MatchFrameBudget)) {
+        // Continue in the next frame; polishing again right away would run
+        // in this one
+        QTimer::singleShot(0, this, [this] { polish(); });
+        return;
+    }
+
+    m_matchPending = false;
+    m_morph = std::make_unique<Morph>(m_matcher->takeMorph());
+    if (MorphDiskCache* diskCache = morphDiskCache()) {
+        diskCache->insert(*m_morph);
+    }
+    m_morphFrom = m_matchFrom;
+    m_morphTo = m_matchTo;
+    m_morphCanonicalCubics = 0;
+    m_restingShape.reset();
+    if (m_animateWhenMatched) {
+        m_animateWhenMatched = false;
+        m_morphProgress = 0.0f;
+        bakeMorph(m_morphFrom, m_morphTo);
+        m_animation->start();
+    }
+    invalidatePath();
 }
 
 void MaterialShapeItem::geometryChange(
@@ -455,6 +1104,9 @@ void MaterialShapeItem::geometryChange(
     if (newGeometry.size() != oldGeometry.size()) {
         m_pathDirty = true;
         m_polygonsDirty = true;
+        m_cubicDataDirty = true;
+        m_bakedPaths.assign(m_bakedPaths.size(), QPainterPath());
+        m_paintedRect = QRectF();
     }
     QQuickPaintedItem::geometryChange(newGeometry, oldGeometry);
 }
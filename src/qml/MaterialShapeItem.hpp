@@ -1,15 +1,19 @@
 #pragma once
 
+#include "../morph/BakedMorph.hpp"
 #include "../morph/Morph.hpp"
+#include "../morph/MorphMatcher.hpp"
+#include "../morph/PreparedShape.hpp"
 #include "../shapes/MaterialShapes.hpp"
+#include <QByteArray>
 #include <QEasingCurve>
 #include <QPainter>
 #include <QPainterPath>
 #include <QPropertyAnimation>
 #include <QQuickPaintedItem>
+#include <QVariantAnimation>
 #include <QVariantList>
 #include <memory>
-#include <optional>
 
 namespace RoundedPolygon {
 
@@ -31,14 +35,56 @@ public:
     explicit RoundedPolygonWrapper(
         const RoundedPolygon::RoundedPolygonShape& shape);
 
-    [[nodiscard]] bool isValid() const { return m_shape.has_value(); }
+    /**
+     * Wrap a shape built only as an outline. Its features are built the
+     * first time it is morphed, so shapes that are only drawn never pay for
+     * them.
+     */
+    explicit RoundedPolygonWrapper(RoundedPolygon::OutlineShape outline);
+
+    /**
+     * Wrap a shape that is already prepared, sharing it.
+     */
+    explicit RoundedPolygonWrapper(
+        std::shared_ptr<const RoundedPolygon::PreparedShape> prepared);
+
+    [[nodiscard]] bool isValid() const { return m_prepared != nullptr; }
 
     [[nodiscard]] const RoundedPolygon::RoundedPolygonShape& shape() const;
 
+    /**
+     * The shape prepared for morphing. Copies of a wrapper share it, so the
+     * shape is measured at most once however often it is morphed.
+     */
+    [[nodiscard]] const std::shared_ptr<const RoundedPolygon::PreparedShape>&
+    prepared() const {
+        return m_prepared;
+    }
+
+    /**
+     * Wrappers are equal when they share one shape, which takes constant
+     * time to check. Shapes from polygon() are interned by their input, so
+     * wrappers it returned for equal input are always equal.
+     */
+    [[nodiscard]] bool operator==(const RoundedPolygonWrapper& other) const {
+        return m_prepared == other.m_prepared;
+    }
+
+    [[nodiscard]] bool operator!=(const RoundedPolygonWrapper& other) const {
+        return !(*this == other);
+    }
+
     Q_INVOKABLE RoundedPolygonWrapper normalized() const;
 
+    /**
+     * Merge runs of nearly collinear cubics, keeping the outline within
+     * maxError (in shape units) of the original. Useful for polygons with
+     * many unrounded vertices.
+     */
+    Q_INVOKABLE RoundedPolygonWrapper simplified(float maxError) const;
+
 private:
-    std::optional<RoundedPolygon::RoundedPolygonShape> m_shape;
+    std::shared_ptr<const RoundedPolygon::PreparedShape> m_prepared;
 };
 
 /**
@@ -148,10 +194,22 @@ public:
             setCustomFromShape NOTIFY customFromShapeChanged)
     Q_PROPERTY(RoundedPolygonWrapper customToShape READ customToShape WRITE
             setCustomToShape NOTIFY customToShapeChanged)
+    Q_PROPERTY(int bakedFrames READ bakedFrames WRITE setBakedFrames NOTIFY
+            bakedFramesChanged)
+    Q_PROPERTY(int canonicalCubics READ canonicalCubics WRITE
+            setCanonicalCubics NOTIFY canonicalCubicsChanged)
+    Q_PROPERTY(QVariantList loopShapes READ loopShapes WRITE setLoopShapes
+            NOTIFY loopShapesChanged)
+    Q_PROPERTY(float loopRotation READ loopRotation WRITE setLoopRotation
+            NOTIFY loopRotationChanged)
 
     explicit MaterialShapeItem(QQuickItem* parent = nullptr);
 
     // ========== Factory functions for custom shapes ==========
+    //
+    // polygon(), regularPolygon(), star(), rectangle() and squircle() return
+    // the same shared shape to every call with the same arguments, so a
+    // delegate repeated across a list builds and measures its shape once.
 
     /**
      * Create a point with optional rounding for use in polygon().
@@ -176,6 +234,25 @@ public:
         const QVariantList& vertices, int reps = 1, float centerX = 0.5f,
         float centerY = 0.5f, bool mirroring = false);
 
+    /**
+     * Create a custom polygon from a flat array of interleaved x, y, radius
+     * and smoothing values, four per vertex, such as a JS array of numbers.
+     * Builds the same shape as polygon() does from the same vertices without
+     * converting each value from a variant. Returns an invalid shape if the
+     * array is empty or its length is not a multiple of four.
+     */
+    Q_INVOKABLE static RoundedPolygonWrapper polygonFromArray(
+        const QList<float>& values, int reps = 1, float centerX = 0.5f,
+        float centerY = 0.5f, bool mirroring = false);
+
+    /**
+     * Like polygonFromArray(), reading the values as 32-bit floats from a
+     * binary buffer, such as an ArrayBuffer or the buffer of a Float32Array.
+     */
+    Q_INVOKABLE static RoundedPolygonWrapper polygonFromBuffer(
+        const QByteArray& buffer, int reps = 1, float centerX = 0.5f,
+        float centerY = 0.5f, bool mirroring = false);
+
     /**
      * Create a regular polygon with N vertices.
      * @param numVertices Number of vertices (minimum 3)
@@ -210,12 +287,20 @@ public:
      * Uses the equation |x|^n + |y|^n = 1
      * @param n Exponent controlling squareness (2=ellipse, 4=squircle,
      * higher=more square)
-     * @param segments Number of points to generate (default 64,
-     * higher=smoother)
+     * @param segments Accuracy, as a polygon of that many sides, at least 4.
+     * The curve is built from as few cubics as stay that close to it, eight
+     * for n=4 at the default.
      */
     Q_INVOKABLE static RoundedPolygonWrapper squircle(
         float n = 4.0f, int segments = 64);
 
+    /**
+     * Counters of the shapes shared by the factory functions: "hits" and
+     * "misses" of calls that found or built their shape, and "size", the
+     * number of shapes kept.
+     */
+    Q_INVOKABLE static QVariantMap factoryCacheStats();
+
     // ========== Path queries ==========
 
     /**
@@ -244,6 +329,21 @@ public:
      */
     Q_INVOKABLE QRectF pathBounds() const;
 
+    /**
+     * The cubics of the current frame in item-local coordinates, as the
+     * path painted from them: eight 32-bit floats per cubic, anchor0 x/y,
+     * control0 x/y, control1 x/y and anchor1 x/y, in outline order. Reaches
+     * JS as an ArrayBuffer to read through a Float32Array.
+     *
+     * The data is shared with the item's buffer rather than copied. The item
+     * fills that buffer in place at most once per changed frame; while data
+     * handed out for an earlier frame is still referenced, the new frame is
+     * written to a new buffer instead, so handed out data never changes.
+     * Consumers should read the data within the frame and not hold it
+     * across frames, or every frame allocates a new buffer.
+     */
+    Q_INVOKABLE QByteArray cubicData() const;
+
     /**
      * Defer morph rebuilds until the matching endBatchUpdate(). Useful when
      * setting several morph-related properties (fromShape, toShape, custom*)
@@ -321,6 +421,33 @@ public:
 
     void setCustomToShape(const RoundedPolygonWrapper& shape);
 
+    [[nodiscard]] int bakedFrames() const { return m_bakedFrames; }
+
+    void setBakedFrames(int frames);
+
+    [[nodiscard]] int canonicalCubics() const { return m_canonicalCubics; }
+
+    void setCanonicalCubics(int cubics);
+
+    [[nodiscard]] QVariantList loopShapes() const { return m_loopShapes; }
+
+    /**
+     * Loop continuously through the given shapes, morphing from each to the
+     * next for animationDuration ms using animationEasing, and from the last
+     * back to the first. The morphs of the ring are built once when the
+     * shapes are set. Fewer than two shapes stop looping.
+     */
+    void setLoopShapes(const QVariantList& shapes);
+
+    [[nodiscard]] float loopRotation() const { return m_loopRotation; }
+
+    /**
+     * Degrees the shape turns during each step of the loop. The turn keeps
+     * accumulating across laps of the ring, so the shape does not snap back
+     * when the loop wraps around.
+     */
+    void setLoopRotation(float degrees);
+
     bool contains(const QPointF& point) const override;
 
 signals:
@@ -337,6 +464,10 @@ signals:
     void customShapeChanged();
     void customFromShapeChanged();
     void customToShapeChanged();
+    void bakedFramesChanged();
+    void canonicalCubicsChanged();
+    void loopShapesChanged();
+    void loopRotationChanged();
 
 public:
     void paint(QPainter* painter) override;
@@ -344,20 +475,38 @@ public:
 private slots:
     void onAnimationValueChanged(const QVariant& value);
     void onMorphFinished();
+    void onLoopValueChanged(const QVariant& value);
 
 protected:
     void geometryChange(
         const QRectF& newGeometry, const QRectF& oldGeometry) override;
+    void updatePolish() override;
 
 private:
+    // Cubics of the frame to paint, in the unit square, and the rotation to
+    // paint them with
+    const std::vector<RoundedPolygon::Cubic>& frameCubics(
+        float& rotation) const;
     QPainterPath buildPath() const;
+    QPainterPath pathFromCubics(
+        const std::vector<RoundedPolygon::Cubic>& cubics,
+        float rotation = 0.0f) const;
     const QPainterPath& cachedPath() const;
     const QList<QPolygonF>& cachedPolygons() const;
     qreal rayHitDistance(qreal dx, qreal dy) const;
+    QRectF shapeToItemRect(const std::array<float, 4>& bounds) const;
+    QRectF currentShapeRect() const;
     void invalidatePath();
     void startMorph(Shape from, Shape to);
+    // Returns false when the match is spread over the next frames instead
+    bool buildMorph(Shape from, Shape to);
+    void bakeMorph(Shape from, Shape to);
+    void clearBakedMorph();
+    void updateLoopDuration();
+    void updateMorphProgress(float progress);
     void rebuildMorph();
-    RoundedPolygon::RoundedPolygonShape getShapeForEnum(Shape shape) const;
+    std::shared_ptr<const RoundedPolygon::PreparedShape> getShapeForEnum(
+        Shape shape) const;
 
     Shape m_currentShape = Circle;
     Shape m_targetShape = Circle;
@@ -371,13 +520,57 @@ private:
     QColor m_strokeColor = Qt::transparent;
     float m_strokeWidth = 0.0f;
 
+    // Shape painted while no transition is set up; m_morph is only used
+    // while this is null
+    std::shared_ptr<const RoundedPolygon::PreparedShape> m_restingShape;
     std::unique_ptr<RoundedPolygon::Morph> m_morph;
+    // Shapes m_morph was built for, used to reuse it for repeated or
+    // reversed transitions
+    Shape m_morphFrom = Circle;
+    Shape m_morphTo = Circle;
+    int m_morphCanonicalCubics = 0;
+    // Morph between canonical forms when positive, see canonicalCubics
+    int m_canonicalCubics = 0;
     QPropertyAnimation* m_animation = nullptr;
 
+    // Time-sliced matching of large custom morphs. The current morph keeps
+    // being painted until the match is done.
+    std::unique_ptr<RoundedPolygon::MorphMatcher> m_matcher;
+    bool m_matchPending = false;
+    bool m_animateWhenMatched = false;
+    Shape m_matchFrom = Circle;
+    Shape m_matchTo = Circle;
+
+    // Looping through loopShapes. One animation drives the whole ring, and
+    // each frame interpolates into m_frameCubics without allocating.
+    QVariantList m_loopShapes;
+    std::vector<RoundedPolygon::Morph> m_loopMorphs;
+    QVariantAnimation* m_loopAnimation = nullptr;
+    float m_loopRotation = 0.0f;
+    // Position along the ring, in steps
+    float m_loopPhase = 0.0f;
+    // Laps of the ring completed, and the degrees turned by them modulo 360
+    int m_loopLap = 0;
+    float m_loopLapDegrees = 0.0f;
+
+    // Baked playback of animated morphs, see bakedFrames
+    int m_bakedFrames = 0;
+    std::unique_ptr<RoundedPolygon::BakedMorph> m_bakedMorph;
+    Shape m_bakedFrom = Circle;
+    Shape m_bakedTo = Circle;
+    int m_bakedFrame = -1;
+    mutable std::vector<QPainterPath> m_bakedPaths;
+
     mutable QPainterPath m_cachedPath;
     mutable QList<QPolygonF> m_cachedPolygons;
     mutable bool m_pathDirty = true;
     mutable bool m_polygonsDirty = true;
+    // Cubics of the current frame, see frameCubics() and cubicData()
+    mutable std::vector<RoundedPolygon::Cubic> m_frameCubics;
+    mutable QByteArray m_cubicData;
+    mutable bool m_cubicDataDirty = true;
+    // Item-space bounds of the shape as last scheduled for painting
+    QRectF m_paintedRect;
 
     RoundedPolygonWrapper m_customShape;
     RoundedPolygonWrapper m_customFromShape;
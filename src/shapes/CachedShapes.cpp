@@ -0,0 +1,121 @@
+#include "CachedShapes.hpp"
+
+namespace RoundedPolygon {
+
+namespace {
+
+using SharedShape = std::shared_ptr<const RoundedPolygonShape>;
+
+// Roundings enter the keys as their radius and smoothing, and an optional
+// rounding as a flag in front of them
+struct Caches {
+    ShapeCache<RoundedPolygonShape, int, float, float, float, float, bool,
+        float, float, float, float>
+        star{ CachedShapes::Capacity };
+    ShapeCache<RoundedPolygonShape, float, float, float, float, float, float>
+        rectangle{ CachedShapes::Capacity };
+    ShapeCache<RoundedPolygonShape, float, float, float, float, float> pill{
+        CachedShapes::Capacity
+    };
+    ShapeCache<RoundedPolygonShape, float, float, int, float, float, float,
+        bool, float, float, float, float, float, float>
+        pillStar{ CachedShapes::Capacity };
+};
+
+Caches& caches() {
+    static Caches instance;
+    return instance;
+}
+
+} // anonymous namespace
+
+SharedShape CachedShapes::star(int numVerticesPerRadius, float radius,
+    float innerRadius, const CornerRounding& rounding,
+    const CornerRounding* innerRounding, float centerX, float centerY) {
+    CornerRounding inner = innerRounding ? *innerRounding : rounding;
+    return caches().star.get(
+        [](int numVertices, float outer, float innerRatio, float roundingRadius,
+            float roundingSmoothing, bool hasInner, float innerRadiusValue,
+            float innerSmoothing, float x, float y) {
+            CornerRounding innerValue(innerRadiusValue, innerSmoothing);
+            return std::make_shared<const RoundedPolygonShape>(Shapes::star(
+                numVertices, outer, innerRatio,
+                CornerRounding(roundingRadius, roundingSmoothing),
+                hasInner ? &innerValue : nullptr, nullptr, x, y));
+        },
+        numVerticesPerRadius, radius, innerRadius, rounding.radius,
+        rounding.smoothing, innerRounding != nullptr, inner.radius,
+        inner.smoothing, centerX, centerY);
+}
+
+SharedShape CachedShapes::rectangle(float width, float height,
+    const CornerRounding& rounding, float centerX, float centerY) {
+    return caches().rectangle.get(
+        [](float w, float h, float roundingRadius, float roundingSmoothing,
+            float x, float y) {
+            return std::make_shared<const RoundedPolygonShape>(
+                Shapes::rectangle(w, h,
+                    CornerRounding(roundingRadius, roundingSmoothing), nullptr,
+                    x, y));
+        },
+        width, height, rounding.radius, rounding.smoothing, centerX, centerY);
+}
+
+SharedShape CachedShapes::pill(float width, float height, float smoothing,
+    float centerX, float centerY) {
+    return caches().pill.get(
+        [](float w, float h, float s, float x, float y) {
+            return std::make_shared<const RoundedPolygonShape>(
+                Shapes::pill(w, h, s, x, y));
+        },
+        width, height, smoothing, centerX, centerY);
+}
+
+SharedShape CachedShapes::pillStar(float width, float height,
+    int numVerticesPerRadius, float innerRadiusRatio,
+    const CornerRounding& rounding, const CornerRounding* innerRounding,
+    float vertexSpacing, float startLocation, float centerX, float centerY) {
+    CornerRounding inner = innerRounding ? *innerRounding : rounding;
+    return caches().pillStar.get(
+        [](float w, float h, int numVertices, float innerRatio,
+            float roundingRadius, float roundingSmoothing, bool hasInner,
+            float innerRadiusValue, float innerSmoothing, float spacing,
+            float start, float x, float y) {
+            CornerRounding innerValue(innerRadiusValue, innerSmoothing);
+            return std::make_shared<const RoundedPolygonShape>(
+                Shapes::pillStar(w, h, numVertices, innerRatio,
+                    CornerRounding(roundingRadius, roundingSmoothing),
+                    hasInner ? &innerValue : nullptr, nullptr, spacing, start,
+                    x, y));
+        },
+        width, height, numVerticesPerRadius, innerRadiusRatio, rounding.radius,
+        rounding.smoothing, innerRounding != nullptr, inner.radius,
+        inner.smoothing, vertexSpacing, startLocation, centerX, centerY);
+}
+
+void CachedShapes::setQuantum(float quantum) {
+    Caches& all = caches();
+    all.star.setQuantum(quantum);
+    all.rectangle.setQuantum(quantum);
+    all.pill.setQuantum(quantum);
+    all.pillStar.setQuantum(quantum);
+}
+
+ShapeCacheStats CachedShapes::stats() {
+    Caches& all = caches();
+    ShapeCacheStats result = all.star.stats();
+    result += all.rectangle.stats();
+    result += all.pill.stats();
+    result += all.pillStar.stats();
+    return result;
+}
+
+void CachedShapes::clear() {
+    Caches& all = caches();
+    all.star.clear();
+    all.rectangle.clear();
+    all.pill.clear();
+    all.pillStar.clear();
+}
+
+} // namespace RoundedPolygon
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "ShapeCache.hpp"
+#include "Shapes.hpp"
+#include <memory>
+
+namespace RoundedPolygon {
+
+/**
+ * Memoized versions of the Shapes factories, for callers that ask for the
+ * same shapes over and over, such as list delegates. Each returns the shape
+ * Shapes builds from the same arguments, shared with every other call made
+ * with them while it stays among the most recently used shapes.
+ *
+ * Per-vertex rounding is not part of any cache key; build such shapes with
+ * Shapes directly.
+ */
+class CachedShapes {
+public:
+    // Shapes kept by each factory's cache
+    static constexpr size_t Capacity = 64;
+
+    [[nodiscard]] static std::shared_ptr<const RoundedPolygonShape> star(
+        int numVerticesPerRadius, float radius = 1.0f,
+        float innerRadius = 0.5f,
+        const CornerRounding& rounding = CornerRounding::Unrounded,
+        const CornerRounding* innerRounding = nullptr, float centerX = 0.0f,
+        float centerY = 0.0f);
+
+    [[nodiscard]] static std::shared_ptr<const RoundedPolygonShape> rectangle(
+        float width = 2.0f, float height = 2.0f,
+        const CornerRounding& rounding = CornerRounding::Unrounded,
+        float centerX = 0.0f, float centerY = 0.0f);
+
+    [[nodiscard]] static std::shared_ptr<const RoundedPolygonShape> pill(
+        float width = 2.0f, float height = 1.0f, float smoothing = 0.0f,
+        float centerX = 0.0f, float centerY = 0.0f);
+
+    [[nodiscard]] static std::shared_ptr<const RoundedPolygonShape> pillStar(
+        float width = 2.0f, float height = 1.0f, int numVerticesPerRadius = 8,
+        float innerRadiusRatio = 0.5f,
+        const CornerRounding& rounding = CornerRounding::Unrounded,
+        const CornerRounding* innerRounding = nullptr,
+        float vertexSpacing = 0.5f, float startLocation = 0.0f,
+        float centerX = 0.0f, float centerY = 0.0f);
+
+    /**
+     * Round float arguments to multiples of quantum before looking shapes
+     * up, or use them exactly if it is zero, which is the default. Drops the
+     * cached shapes.
+     */
+    static void setQuantum(float quantum);
+
+    /**
+     * Hits, misses and cached shapes of all factories together.
+     */
+    [[nodiscard]] static ShapeCacheStats stats();
+
+    /**
+     * Drop the cached shapes and reset the counters.
+     */
+    static void clear();
+
+private:
+    CachedShapes() = default;
+};
+
+} // namespace RoundedPolygon
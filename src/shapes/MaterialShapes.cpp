@@ -1,5 +1,8 @@
 #include "MaterialShapes.hpp"
+#include <array>
 #include <cmath>
+#include <mutex>
+#include <numbers>
 
 namespace RoundedPolygon {
 
@@ -24,52 +27,63 @@ std::vector<MaterialShapes::PointNRound> MaterialShapes::doRepeat(
     const std::vector<PointNRound>& points, int reps, float centerX,
     float centerY, bool mirroring) {
     std::vector<PointNRound> result;
+    const size_t np = points.size();
+    if (np == 0 || reps <= 0) {
+        return result;
+    }
+
+    // Every repeated point is an input point, or its mirror image, rotated
+    // around the center by a multiple of the section angle
+    const size_t actualReps = static_cast<size_t>(reps) * (mirroring ? 2 : 1);
+    std::vector<float> cosines(actualReps);
+    std::vector<float> sines(actualReps);
+    unitCircle(actualReps, 0.0,
+        2.0 * std::numbers::pi / static_cast<double>(actualReps),
+        cosines.data(), sines.data());
+
+    std::vector<float> dx(np);
+    std::vector<float> dy(np);
+    for (size_t i = 0; i < np; ++i) {
+        dx[i] = points[i].x - centerX;
+        dy[i] = points[i].y - centerY;
+    }
 
+    // Mirror images reflect each point across the line from the center
+    // through the first point
+    std::vector<float> mirroredX;
+    std::vector<float> mirroredY;
     if (mirroring) {
-        // Calculate angles and distances
-        std::vector<float> angles;
-        std::vector<float> distances;
-        for (const auto& p : points) {
-            float dx = p.x - centerX;
-            float dy = p.y - centerY;
-            angles.push_back(std::atan2(dy, dx) * 180.0f / FloatPi);
-            distances.push_back(std::sqrt(dx * dx + dy * dy));
+        // A first point on the center leaves no axis, so use the x axis
+        const Point axis = distance(dx[0], dy[0]) < DistanceEpsilon
+            ? Point(1.0f, 0.0f)
+            : directionVector(dx[0], dy[0]);
+        mirroredX.resize(np);
+        mirroredY.resize(np);
+        for (size_t i = 0; i < np; ++i) {
+            float along = dx[i] * axis.x + dy[i] * axis.y;
+            mirroredX[i] = 2.0f * along * axis.x - dx[i];
+            mirroredY[i] = 2.0f * along * axis.y - dy[i];
         }
+    }
 
-        size_t actualReps = static_cast<size_t>(reps) * 2;
-        float sectionAngle = 360.0f / static_cast<float>(actualReps);
-
-        for (size_t rep = 0; rep < actualReps; ++rep) {
-            for (size_t index = 0; index < points.size(); ++index) {
-                size_t i = (rep % 2 == 0) ? index : points.size() - 1 - index;
-                if (i > 0 || rep % 2 == 0) {
-                    float a;
-                    if (rep % 2 == 0) {
-                        a = sectionAngle * static_cast<float>(rep) + angles[i];
-                    } else {
-                        a = sectionAngle * static_cast<float>(rep) +
-                            sectionAngle - angles[i] + 2 * angles[0];
-                    }
-                    float rad = a * FloatPi / 180.0f;
-                    float finalX = std::cos(rad) * distances[i] + centerX;
-                    float finalY = std::sin(rad) * distances[i] + centerY;
-                    result.emplace_back(finalX, finalY, points[i].rounding);
-                }
-            }
-        }
-    } else {
-        size_t np = points.size();
-        for (size_t rep = 0; rep < static_cast<size_t>(reps); ++rep) {
-            for (size_t i = 0; i < np; ++i) {
-                float angle =
-                    360.0f / static_cast<float>(reps) * static_cast<float>(rep);
-                float rad = angle * FloatPi / 180.0f;
-                float dx = points[i].x - centerX;
-                float dy = points[i].y - centerY;
-                float newX = dx * std::cos(rad) - dy * std::sin(rad) + centerX;
-                float newY = dx * std::sin(rad) + dy * std::cos(rad) + centerY;
-                result.emplace_back(newX, newY, points[i].rounding);
+    result.reserve(actualReps * np);
+    for (size_t rep = 0; rep < actualReps; ++rep) {
+        // Mirrored sections end where the next section starts, run
+        // backwards and skip the first point, which lies on the mirror axis
+        const bool mirrored = mirroring && rep % 2 == 1;
+        const size_t angle = mirrored ? (rep + 1) % actualReps : rep;
+        const float cosA = cosines[angle];
+        const float sinA = sines[angle];
+        const float* x = mirrored ? mirroredX.data() : dx.data();
+        const float* y = mirrored ? mirroredY.data() : dy.data();
+
+        for (size_t index = 0; index < np; ++index) {
+            size_t i = mirrored ? np - 1 - index : index;
+            if (mirrored && i == 0) {
+                continue;
             }
+            result.emplace_back(x[i] * cosA - y[i] * sinA + centerX,
+                x[i] * sinA + y[i] * cosA + centerY, points[i].rounding);
         }
     }
 
@@ -394,7 +408,27 @@ RoundedPolygonShape MaterialShapes::heart() {
         .normalized();
 }
 
-RoundedPolygonShape MaterialShapes::getShape(ShapeType type) {
+std::shared_ptr<const RoundedPolygonShape> MaterialShapes::getShape(
+    ShapeType type) {
+    struct Entry {
+        std::once_flag once;
+        std::shared_ptr<const RoundedPolygonShape> shape;
+    };
+    static std::array<Entry, ShapeTypeCount> registry;
+
+    const auto index = static_cast<size_t>(type);
+    if (index >= ShapeTypeCount) {
+        return getShape(ShapeType::Circle);
+    }
+    Entry& entry = registry[index];
+    std::call_once(entry.once, [&entry, type] {
+        entry.shape =
+            std::make_shared<const RoundedPolygonShape>(buildShape(type));
+    });
+    return entry.shape;
+}
+
+RoundedPolygonShape MaterialShapes::buildShape(ShapeType type) {
     switch (type) {
     case ShapeType::Circle:
         return circle();
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Shapes.hpp"
+#include <memory>
 
 namespace RoundedPolygon {
 
@@ -86,8 +87,16 @@ public:
         Heart
     };
 
-    // Get shape by type
-    [[nodiscard]] static RoundedPolygonShape getShape(ShapeType type);
+    static constexpr size_t ShapeTypeCount =
+        static_cast<size_t>(ShapeType::Heart) + 1;
+
+    /**
+     * The shape of the given type, shared by every caller. Each shape is
+     * built once, the first time it is asked for, and is immutable, so the
+     * returned handle is cheap to copy and safe to use from any thread.
+     */
+    [[nodiscard]] static std::shared_ptr<const RoundedPolygonShape> getShape(
+        ShapeType type);
 
     // Helper struct for custom polygon construction
     struct PointNRound {
@@ -124,6 +133,9 @@ private:
     // Rotation helper
     static RoundedPolygonShape rotated(
         const RoundedPolygonShape& shape, float degrees);
+
+    // Build a fresh shape of the given type
+    static RoundedPolygonShape buildShape(ShapeType type);
 };
 
 } // namespace RoundedPolygon
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+
+namespace RoundedPolygon {
+
+/**
+ * Counters of a ShapeCache, or of several added together.
+ */
+struct ShapeCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    size_t size = 0;
+
+    ShapeCacheStats& operator+=(const ShapeCacheStats& other) {
+        hits += other.hits;
+        misses += other.misses;
+        size += other.size;
+        return *this;
+    }
+};
+
+/**
+ * ShapeCache memoizes a shape factory by the tuple of its arguments and hands
+ * out the shapes it built as shared immutable values. It keeps at most
+ * capacity shapes, dropping the least recently used one to make room, and
+ * may be used from several threads.
+ *
+ * With a nonzero quantum, floating point arguments are rounded to multiples
+ * of it and the factory is called with the rounded values, so arguments
+ * closer than half the quantum share one shape. Arguments that are NaN are
+ * never cached.
+ */
+template <typename Value, typename... Args>
+class ShapeCache {
+public:
+    explicit ShapeCache(size_t capacity, float quantum = 0.0f)
+        : m_capacity(capacity)
+        , m_quantum(quantum) {}
+
+    ShapeCache(const ShapeCache&) = delete;
+    ShapeCache& operator=(const ShapeCache&) = delete;
+
+    /**
+     * The shape for args, calling factory(args...) to build it unless it is
+     * cached. factory returns a std::shared_ptr<const Value>, and is called
+     * without holding the cache's lock. Exceptions from it are passed on and
+     * leave the cache unchanged.
+     */
+    template <typename Factory>
+    [[nodiscard]] std::shared_ptr<const Value> get(
+        Factory&& factory, Args... args) {
+        std::unique_lock lock(m_mutex);
+        Key key(quantized(args, m_quantum)...);
+        bool cacheable = std::apply(
+            [](const auto&... values) { return (orderable(values) && ...); },
+            key);
+        if (cacheable) {
+            auto found = m_entries.find(key);
+            if (found != m_entries.end()) {
+                ++m_hits;
+                m_order.splice(
+                    m_order.begin(), m_order, found->second.position);
+                return found->second.value;
+            }
+        }
+        ++m_misses;
+        lock.unlock();
+
+        std::shared_ptr<const Value> value = std::apply(factory, key);
+        if (!cacheable) {
+            return value;
+        }
+
+        lock.lock();
+        auto [entry, inserted] = m_entries.try_emplace(key);
+        if (!inserted) {
+            // Another thread built the same shape meanwhile
+            return entry->second.value;
+        }
+        m_order.push_front(key);
+        entry->second = { value, m_order.begin() };
+        while (m_entries.size() > m_capacity) {
+            m_entries.erase(m_order.back());
+            m_order.pop_back();
+        }
+        return value;
+    }
+
+    /**
+     * Round floating point arguments to multiples of quantum from now on,
+     * or use them exactly if it is zero. Drops the cached shapes.
+     */
+    void setQuantum(float quantum) {
+        std::lock_guard lock(m_mutex);
+        m_quantum = quantum;
+        m_entries.clear();
+        m_order.clear();
+    }
+
+    [[nodiscard]] ShapeCacheStats stats() const {
+        std::lock_guard lock(m_mutex);
+        return { m_hits, m_misses, m_entries.size() };
+    }
+
+    /**
+     * Drop the cached shapes and reset the counters.
+     */
+    void clear() {
+        std::lock_guard lock(m_mutex);
+        m_entries.clear();
+        m_order.clear();
+        m_hits = 0;
+        m_misses = 0;
+    }
+
+private:
+    using Key = std::tuple<Args...>;
+
+    struct Entry {
+        std::shared_ptr<const Value> value;
+        // Place of the key in m_order
+        typename std::list<Key>::iterator position;
+    };
+
+    const size_t m_capacity;
+    float m_quantum;
+
+    mutable std::mutex m_mutex;
+    std::map<Key, Entry> m_entries;
+    // Keys from most to least recently used
+    std::list<Key> m_order;
+    uint64_t m_hits = 0;
+    uint64_t m_misses = 0;
+
+    template <typename T>
+    [[nodiscard]] static T quantized(T value, float quantum) {
+        if constexpr (std::is_floating_point_v<T>) {
+            if (quantum > 0.0f) {
+                return std::round(value / static_cast<T>(quantum)) *
+                    static_cast<T>(quantum);
+            }
+        }
+        return value;
+    }
+
+    template <typename T>
+    [[nodiscard]] static bool orderable(const T& value) {
+        if constexpr (std::is_floating_point_v<T>) {
+            return !std::isnan(value);
+        }
+        return true;
+    }
+};
+
+} // namespace RoundedPolygon
@@ -0,0 +1,380 @@
+#include "ShapePack.hpp"
+#include <QFile>
+#include <QSaveFile>
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+
+namespace RoundedPolygon {
+
+namespace {
+
+constexpr char Magic[4] = { 'M', '3', 'S', 'P' };
+
+// Kinds of feature spans
+constexpr uint32_t EdgeFeature = 0;
+constexpr uint32_t ConvexCornerFeature = 1;
+constexpr uint32_t ConcaveCornerFeature = 2;
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t shapeCount;
+    uint32_t featureCount;
+    uint32_t cubicCount;
+    uint32_t nameSize;
+    uint32_t reserved[2];
+};
+
+struct ShapeRecord {
+    uint32_t nameOffset;
+    uint32_t nameSize;
+    uint32_t firstCubic;
+    uint32_t cubicCount;
+    uint32_t firstFeature;
+    uint32_t featureCount;
+    float center[2];
+    float bounds[4];
+};
+
+struct FeatureRecord {
+    uint32_t firstCubic;
+    uint32_t cubicCount;
+    uint32_t kind;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(Header) == 32);
+static_assert(sizeof(ShapeRecord) == 48);
+static_assert(sizeof(FeatureRecord) == 16);
+// Cubics are read from the pack as they lie
+static_assert(sizeof(Cubic) == 8 * sizeof(float));
+static_assert(alignof(Cubic) == alignof(float));
+static_assert(std::is_standard_layout_v<Cubic>);
+static_assert(std::is_trivially_copyable_v<Cubic>);
+
+// Bytes taken by a pack with these counts, or by its tables up to the
+// names when nameSize is zero
+uint64_t packSize(uint64_t shapeCount, uint64_t featureCount,
+    uint64_t cubicCount, uint64_t nameSize) {
+    return sizeof(Header) +
+        shapeCount * (sizeof(ShapeRecord) + sizeof(uint32_t)) +
+        featureCount * sizeof(FeatureRecord) + cubicCount * sizeof(Cubic) +
+        nameSize;
+}
+
+void checkByteOrder() {
+    if constexpr (std::endian::native != std::endian::little) {
+        throw std::runtime_error(
+            "Shape packs are only supported on little-endian hosts");
+    }
+}
+
+} // anonymous namespace
+
+struct PackedShape::Data {
+    // Keeps the mapping alive, or null for data owned by the caller
+    std::unique_ptr<QFile> file;
+
+    uint32_t shapeCount = 0;
+    const ShapeRecord* shapes = nullptr;
+    const uint32_t* nameIndex = nullptr;
+    const FeatureRecord* features = nullptr;
+    const Cubic* cubics = nullptr;
+    const char* names = nullptr;
+
+    [[nodiscard]] std::string_view name(size_t index) const {
+        const ShapeRecord& record = shapes[index];
+        return { names + record.nameOffset, record.nameSize };
+    }
+
+    // Point the tables into data, checking that every span in them lies
+    // within it
+    void read(std::span<const std::byte> data) {
+        checkByteOrder();
+        if (reinterpret_cast<uintptr_t>(data.data()) % alignof(uint32_t) !=
+            0) {
+            throw std::invalid_argument("Shape pack data is not aligned");
+        }
+        Header header;
+        if (data.size() < sizeof(Header)) {
+            throw std::invalid_argument("Shape pack is truncated");
+        }
+        std::memcpy(&header, data.data(), sizeof(Header));
+        if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0) {
+            throw std::invalid_argument("Data is not a shape pack");
+        }
+        if (header.version != ShapePack::Version) {
+            throw std::invalid_argument("Unsupported shape pack version " +
+                std::to_string(header.version));
+        }
+        if (packSize(header.shapeCount, header.featureCount,
+                header.cubicCount, header.nameSize) != data.size()) {
+            throw std::invalid_argument(
+                "Shape pack size does not match its header");
+        }
+
+        const std::byte* position = data.data() + sizeof(Header);
+        shapeCount = header.shapeCount;
+        shapes = reinterpret_cast<const ShapeRecord*>(position);
+        position += sizeof(ShapeRecord) * shapeCount;
+        nameIndex = reinterpret_cast<const uint32_t*>(position);
+        position += sizeof(uint32_t) * shapeCount;
+        features = reinterpret_cast<const FeatureRecord*>(position);
+        position += sizeof(FeatureRecord) * header.featureCount;
+        cubics = reinterpret_cast<const Cubic*>(position);
+        position += sizeof(Cubic) * header.cubicCount;
+        names = reinterpret_cast<const char*>(position);
+
+        auto within = [](uint64_t first, uint64_t count, uint64_t size) {
+            return first + count <= size;
+        };
+        for (uint32_t i = 0; i < shapeCount; ++i) {
+            const ShapeRecord& record = shapes[i];
+            if (!within(record.nameOffset, record.nameSize, header.nameSize) ||
+                !within(
+                    record.firstCubic, record.cubicCount, header.cubicCount) ||
+                !within(record.firstFeature, record.featureCount,
+                    header.featureCount)) {
+                throw std::invalid_argument(
+                    "Shape pack has a shape outside of its tables");
+            }
+        }
+        for (uint32_t i = 0; i < header.featureCount; ++i) {
+            const FeatureRecord& record = features[i];
+            if (record.cubicCount == 0 ||
+                !within(
+                    record.firstCubic, record.cubicCount, header.cubicCount) ||
+                record.kind > ConcaveCornerFeature) {
+                throw std::invalid_argument(
+                    "Shape pack has an invalid feature");
+            }
+        }
+        // Binary search needs names in strictly increasing order
+        for (uint32_t i = 0; i < shapeCount; ++i) {
+            if (nameIndex[i] >= shapeCount ||
+                (i > 0 && name(nameIndex[i - 1]) >= name(nameIndex[i]))) {
+                throw std::invalid_argument(
+                    "Shape pack has an invalid name index");
+            }
+        }
+    }
+};
+
+std::string_view PackedShape::name() const {
+    return m_data->name(m_index);
+}
+
+std::span<const Cubic> PackedShape::cubics() const {
+    const ShapeRecord& record = m_data->shapes[m_index];
+    return { m_data->cubics + record.firstCubic, record.cubicCount };
+}
+
+Point PackedShape::center() const {
+    const ShapeRecord& record = m_data->shapes[m_index];
+    return Point(record.center[0], record.center[1]);
+}
+
+std::array<float, 4> PackedShape::bounds() const {
+    const ShapeRecord& record = m_data->shapes[m_index];
+    return { record.bounds[0], record.bounds[1], record.bounds[2],
+        record.bounds[3] };
+}
+
+size_t PackedShape::featureCount() const {
+    return m_data->shapes[m_index].featureCount;
+}
+
+RoundedPolygonShape PackedShape::shape() const {
+    const ShapeRecord& record = m_data->shapes[m_index];
+    std::vector<std::unique_ptr<Feature>> features;
+    features.reserve(record.featureCount);
+    for (uint32_t i = 0; i < record.featureCount; ++i) {
+        const FeatureRecord& feature =
+            m_data->features[record.firstFeature + i];
+        const Cubic* first = m_data->cubics + feature.firstCubic;
+        std::vector<Cubic> cubics(first, first + feature.cubicCount);
+        switch (feature.kind) {
+        case EdgeFeature:
+            features.push_back(cubics.size() == 1
+                    ? Feature::buildEdge(cubics.front())
+                    : Feature::buildIgnorableFeature(cubics));
+            break;
+        case ConvexCornerFeature:
+            features.push_back(Feature::buildConvexCorner(cubics));
+            break;
+        default:
+            features.push_back(Feature::buildConcaveCorner(cubics));
+            break;
+        }
+    }
+    return RoundedPolygonShape(std::move(features), center());
+}
+
+ShapePack::ShapePack(const std::string& path) {
+    auto data = std::make_shared<PackedShape::Data>();
+    data->file = std::make_unique<QFile>(QString::fromStdString(path));
+    QFile& file = *data->file;
+    if (!file.open(QIODevice::ReadOnly)) {
+        throw std::runtime_error("Cannot open shape pack " + path + ": " +
+            file.errorString().toStdString());
+    }
+    const qint64 size = file.size();
+    if (size < static_cast<qint64>(sizeof(Header))) {
+        throw std::invalid_argument("Shape pack " + path + " is truncated");
+    }
+    const uchar* mapped = file.map(0, size);
+    if (mapped == nullptr) {
+        throw std::runtime_error("Cannot map shape pack " + path + ": " +
+            file.errorString().toStdString());
+    }
+    data->read({ reinterpret_cast<const std::byte*>(mapped),
+        static_cast<size_t>(size) });
+    m_data = std::move(data);
+}
+
+ShapePack::ShapePack(std::span<const std::byte> data) {
+    auto result = std::make_shared<PackedShape::Data>();
+    result->read(data);
+    m_data = std::move(result);
+}
+
+size_t ShapePack::size() const {
+    return m_data->shapeCount;
+}
+
+PackedShape ShapePack::at(size_t index) const {
+    if (index >= m_data->shapeCount) {
+        throw std::out_of_range("Shape pack index out of range");
+    }
+    return PackedShape(m_data.get(), index);
+}
+
+std::optional<PackedShape> ShapePack::find(std::string_view name) const {
+    const PackedShape::Data& data = *m_data;
+    const uint32_t* end = data.nameIndex + data.shapeCount;
+    const uint32_t* found = std::lower_bound(data.nameIndex, end, name,
+        [&data](uint32_t index, std::string_view key) {
+            return data.name(index) < key;
+        });
+    if (found == end || data.name(*found) != name) {
+        return std::nullopt;
+    }
+    return PackedShape(m_data.get(), *found);
+}
+
+void ShapePackWriter::add(
+    const std::string& name, const RoundedPolygonShape& shape) {
+    if (!m_names.insert(name).second) {
+        throw std::invalid_argument(
+            "Shape pack already has a shape named " + name);
+    }
+    Shape entry{ name, shape.cubics(), shape.center(),
+        shape.calculateBounds(false), {} };
+    entry.features.reserve(shape.features().size());
+    for (const auto& feature : shape.features()) {
+        uint32_t kind = feature->isConvexCorner() ? ConvexCornerFeature
+            : feature->isConcaveCorner()          ? ConcaveCornerFeature
+                                                  : EdgeFeature;
+        entry.features.emplace_back(kind, feature->cubics());
+    }
+    m_shapes.push_back(std::move(entry));
+}
+
+std::vector<std::byte> ShapePackWriter::bytes() const {
+    checkByteOrder();
+    size_t featureCount = 0;
+    size_t cubicCount = 0;
+    size_t nameSize = 0;
+    for (const auto& shape : m_shapes) {
+        featureCount += shape.features.size();
+        cubicCount += shape.cubics.size();
+        for (const auto& feature : shape.features) {
+            cubicCount += feature.second.size();
+        }
+        nameSize += shape.name.size();
+    }
+
+    std::vector<std::byte> result(
+        packSize(m_shapes.size(), featureCount, cubicCount, nameSize));
+    std::byte* shapes = result.data() + sizeof(Header);
+    std::byte* nameIndex = shapes + sizeof(ShapeRecord) * m_shapes.size();
+    std::byte* features = nameIndex + sizeof(uint32_t) * m_shapes.size();
+    std::byte* cubics = features + sizeof(FeatureRecord) * featureCount;
+    std::byte* names = cubics + sizeof(Cubic) * cubicCount;
+
+    Header header{};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = ShapePack::Version;
+    header.shapeCount = static_cast<uint32_t>(m_shapes.size());
+    header.featureCount = static_cast<uint32_t>(featureCount);
+    header.cubicCount = static_cast<uint32_t>(cubicCount);
+    header.nameSize = static_cast<uint32_t>(nameSize);
+    std::memcpy(result.data(), &header, sizeof(Header));
+
+    uint32_t nextFeature = 0;
+    uint32_t nextCubic = 0;
+    uint32_t nextName = 0;
+    auto writeCubics = [&cubics, &nextCubic](const std::vector<Cubic>& from) {
+        std::memcpy(cubics + sizeof(Cubic) * nextCubic, from.data(),
+            sizeof(Cubic) * from.size());
+        nextCubic += static_cast<uint32_t>(from.size());
+    };
+    for (size_t i = 0; i < m_shapes.size(); ++i) {
+        const Shape& shape = m_shapes[i];
+        ShapeRecord record{};
+        record.nameOffset = nextName;
+        record.nameSize = static_cast<uint32_t>(shape.name.size());
+        std::memcpy(names + nextName, shape.name.data(), shape.name.size());
+        nextName += record.nameSize;
+
+        record.firstCubic = nextCubic;
+        record.cubicCount = static_cast<uint32_t>(shape.cubics.size());
+        writeCubics(shape.cubics);
+
+        record.firstFeature = nextFeature;
+        record.featureCount = static_cast<uint32_t>(shape.features.size());
+        for (const auto& [kind, featureCubics] : shape.features) {
+            FeatureRecord feature{};
+            feature.firstCubic = nextCubic;
+            feature.cubicCount = static_cast<uint32_t>(featureCubics.size());
+            feature.kind = kind;
+            std::memcpy(features + sizeof(FeatureRecord) * nextFeature,
+                &feature, sizeof(FeatureRecord));
+            ++nextFeature;
+            writeCubics(featureCubics);
+        }
+
+        record.center[0] = shape.center.x;
+        record.center[1] = shape.center.y;
+        std::copy(shape.bounds.begin(), shape.bounds.end(), record.bounds);
+        std::memcpy(shapes + sizeof(ShapeRecord) * i, &record,
+            sizeof(ShapeRecord));
+    }
+
+    std::vector<uint32_t> order(m_shapes.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+        return m_shapes[a].name < m_shapes[b].name;
+    });
+    std::memcpy(nameIndex, order.data(), sizeof(uint32_t) * order.size());
+    return result;
+}
+
+void ShapePackWriter::write(const std::string& path) const {
+    std::vector<std::byte> data = bytes();
+    QSaveFile file(QString::fromStdString(path));
+    if (!file.open(QIODevice::WriteOnly) ||
+        file.write(reinterpret_cast<const char*>(data.data()),
+            static_cast<qint64>(data.size())) !=
+            static_cast<qint64>(data.size()) ||
+        !file.commit()) {
+        throw std::runtime_error("Cannot write shape pack " + path + ": " +
+            file.errorString().toStdString());
+    }
+}
+
+} // namespace RoundedPolygon
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "core/RoundedPolygon.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <set>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace RoundedPolygon {
+
+/**
+ * A shape stored in a ShapePack. It points into the pack's data and stays
+ * valid for as long as any copy of the pack does.
+ */
+class PackedShape {
+public:
+    [[nodiscard]] std::string_view name() const;
+
+    /**
+     * The closed outline, as RoundedPolygonShape::cubics() returned it when
+     * the shape was written. Read from the pack in place.
+     */
+    [[nodiscard]] std::span<const Cubic> cubics() const;
+
+    [[nodiscard]] Point center() const;
+
+    // Exact bounds of the outline, computed when the shape was written
+    // bounds[0]=left, bounds[1]=top, bounds[2]=right, bounds[3]=bottom
+    [[nodiscard]] std::array<float, 4> bounds() const;
+
+    [[nodiscard]] size_t featureCount() const;
+
+    /**
+     * The full shape with features, for morphing. Copies the cubics of the
+     * features out of the pack.
+     */
+    [[nodiscard]] RoundedPolygonShape shape() const;
+
+private:
+    friend class ShapePack;
+    struct Data;
+
+    PackedShape(const Data* data, size_t index)
+        : m_data(data)
+        , m_index(index) {}
+
+    const Data* m_data;
+    size_t m_index;
+};
+
+/**
+ * ShapePack reads a collection of named shapes from the binary format written
+ * by ShapePackWriter. The file is mapped into memory and its shapes are read
+ * from the mapped pages as they are used; opening a pack only checks that
+ * its tables are consistent, without decoding or copying any shape.
+ *
+ * The format stores, after a versioned header, a table of shapes with their
+ * names, centers and bounds, an index of the shapes sorted by name, a table
+ * of feature spans, the cubics of all outlines and features as eight floats
+ * each, and the names. Everything is in little-endian byte order and 4-byte
+ * aligned, so the tables can be used where they lie.
+ *
+ * Copies of a pack share its mapping.
+ */
+class ShapePack {
+public:
+    // Version written by ShapePackWriter and the only one read
+    static constexpr uint32_t Version = 1;
+
+    /**
+     * Map the pack at path, which may also be an uncompressed Qt resource.
+     * Throws std::runtime_error if the file cannot be mapped and
+     * std::invalid_argument if it is not a pack of this version.
+     */
+    explicit ShapePack(const std::string& path);
+
+    /**
+     * Read a pack from memory that outlives it, such as data compiled into
+     * the program. data must be 4-byte aligned. Throws std::invalid_argument
+     * if it is not a pack of this version.
+     */
+    explicit ShapePack(std::span<const std::byte> data);
+
+    [[nodiscard]] size_t size() const;
+
+    /**
+     * The shape at index, in the order the shapes were written. Throws
+     * std::out_of_range if there is no such shape.
+     */
+    [[nodiscard]] PackedShape at(size_t index) const;
+
+    /**
+     * The shape with the given name, found by binary search of the name
+     * index, or nothing if the pack has no such shape.
+     */
+    [[nodiscard]] std::optional<PackedShape> find(std::string_view name) const;
+
+private:
+    std::shared_ptr<const PackedShape::Data> m_data;
+};
+
+/**
+ * ShapePackWriter collects named shapes and writes them as a ShapePack.
+ */
+class ShapePackWriter {
+public:
+    /**
+     * Add a shape under name, which must not be taken by another shape of
+     * the pack. Throws std::invalid_argument if it is.
+     */
+    void add(const std::string& name, const RoundedPolygonShape& shape);
+
+    [[nodiscard]] size_t size() const { return m_shapes.size(); }
+
+    /**
+     * The pack as it would be written to a file.
+     */
+    [[nodiscard]] std::vector<std::byte> bytes() const;
+
+    /**
+     * Write the pack to path, replacing any file there only once the whole
+     * pack is written. Throws std::runtime_error if it cannot be written.
+     */
+    void write(const std::string& path) const;
+
+private:
+    struct Shape {
+        std::string name;
+        std::vector<Cubic> cubics;
+        Point center;
+        std::array<float, 4> bounds;
+        // Cubics of each feature, tagged with its kind
+        std::vector<std::pair<uint32_t, std::vector<Cubic>>> features;
+    };
+
+    std::vector<Shape> m_shapes;
+    std::set<std::string, std::less<>> m_names;
+};
+
+} // namespace RoundedPolygon
@@ -1,9 +1,232 @@
 #include "Shapes.hpp"
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <numbers>
 #include <stdexcept>
 
 namespace RoundedPolygon {
 
+namespace {
+
+// Bisections allowed when fitting one quadrant of a superellipse, which caps
+// it at 2^MaxQuadrantDepth cubics
+constexpr int MaxQuadrantDepth = 6;
+// Points sampled to fit each cubic and to check it against the curve
+constexpr int FitSamples = 16;
+// Gauss-Newton steps fitting each cubic
+constexpr int FitIterations = 8;
+// Change of the handle lengths used to estimate the residuals' derivatives,
+// as a fraction of the chord
+constexpr float FitDerivativeStep = 1e-3f;
+// Curve points searched for the one nearest to each point of a cubic, and
+// golden-section steps refining it
+constexpr int NearestSamples = 32;
+constexpr int NearestIterations = 24;
+
+// Point and unit tangent of the unit superellipse |x|^n + |y|^n = 1 in its
+// first quadrant, at the parameter t with cos(t) = c and sin(t) = s
+struct CurvePoint {
+    Point point;
+    Point tangent;
+};
+
+CurvePoint superellipsePoint(double exponent, double c, double s) {
+    Point point(static_cast<float>(std::pow(c, 2.0 / exponent)),
+        static_cast<float>(std::pow(s, 2.0 / exponent)));
+
+    // The normal is (x^(n-1), y^(n-1)) = (c^e, s^e). Below n = 1 that is
+    // infinite on the axes, so it is scaled by (cs)^-e to stay finite there.
+    double e = 2.0 * (exponent - 1.0) / exponent;
+    double normalX = e >= 0.0 ? std::pow(c, e) : std::pow(s, -e);
+    double normalY = e >= 0.0 ? std::pow(s, e) : std::pow(c, -e);
+    return { point,
+        directionVector(static_cast<float>(-normalY),
+            static_cast<float>(normalX)) };
+}
+
+using Residuals = std::array<float, FitSamples - 1>;
+
+// Signed distances between sampled points of the cubic and the curve, taken
+// along the ray from the center. Their size is never less than the distance
+// to the nearest point of the curve.
+void radialResiduals(
+    double exponent, const Cubic& cubic, Residuals& residuals) {
+    for (size_t i = 0; i < residuals.size(); ++i) {
+        Point p = cubic.pointOnCurve(
+            static_cast<float>(i + 1) / static_cast<float>(FitSamples));
+        double level = std::pow(std::pow(std::abs(p.x), exponent) +
+                std::pow(std::abs(p.y), exponent),
+            1.0 / exponent);
+        residuals[i] = level > 0.0
+            ? p.getDistance() * static_cast<float>(1.0 - 1.0 / level)
+            : 0.0f;
+    }
+}
+
+float radialError(double exponent, const Cubic& cubic) {
+    Residuals residuals;
+    radialResiduals(exponent, cubic, residuals);
+    float result = 0.0f;
+    for (float residual : residuals) {
+        result = std::max(result, std::abs(residual));
+    }
+    return result;
+}
+
+// Point of the unit superellipse in its first quadrant at the parameter t
+Point superellipseAt(double exponent, double t) {
+    const double power = 2.0 / exponent;
+    return Point(
+        static_cast<float>(std::pow(std::max(std::cos(t), 0.0), power)),
+        static_cast<float>(std::pow(std::max(std::sin(t), 0.0), power)));
+}
+
+// Largest distance between sampled points of the cubic and the nearest point
+// of the curve between the parameters t0 and t1. Where the curve runs at a
+// slant to the rays from the center, as near the axes for small exponents,
+// this is much less than the radial error.
+float nearestError(double exponent, double t0, double t1, const Cubic& cubic) {
+    auto parameter = [t0, t1](double k) {
+        return t0 + (t1 - t0) * k / NearestSamples;
+    };
+    std::array<Point, NearestSamples + 1> curve;
+    for (size_t k = 0; k < curve.size(); ++k) {
+        curve[k] = superellipseAt(exponent, parameter(static_cast<double>(k)));
+    }
+
+    float result = 0.0f;
+    for (int i = 1; i < FitSamples; ++i) {
+        Point p = cubic.pointOnCurve(
+            static_cast<float>(i) / static_cast<float>(FitSamples));
+        size_t nearest = 0;
+        for (size_t k = 1; k < curve.size(); ++k) {
+            if ((curve[k] - p).getDistanceSquared() <
+                (curve[nearest] - p).getDistanceSquared()) {
+                nearest = k;
+            }
+        }
+
+        // The nearest point lies between the neighbours of the nearest sample
+        auto distance = [exponent, &p](double t) {
+            return (superellipseAt(exponent, t) - p).getDistance();
+        };
+        const double ratio = (std::sqrt(5.0) - 1.0) / 2.0;
+        double a =
+            parameter(static_cast<double>(nearest > 0 ? nearest - 1 : 0));
+        double b = parameter(
+            static_cast<double>(std::min(nearest + 1, curve.size() - 1)));
+        double c = b - ratio * (b - a);
+        double d = a + ratio * (b - a);
+        float fc = distance(c);
+        float fd = distance(d);
+        for (int iteration = 0; iteration < NearestIterations; ++iteration) {
+            if (fc < fd) {
+                b = d;
+                d = c;
+                fd = fc;
+                c = b - ratio * (b - a);
+                fc = distance(c);
+            } else {
+                a = c;
+                c = d;
+                fc = fd;
+                d = a + ratio * (b - a);
+                fd = distance(d);
+            }
+        }
+        result = std::max(result,
+            std::min({ fc, fd, (curve[nearest] - p).getDistance() }));
+    }
+    return result;
+}
+
+// Whether each point of the cubic lies within maxError of the curve between
+// the parameters t0 and t1, trying the cheaper radial error first
+bool withinError(
+    double exponent, double t0, double t1, const Cubic& cubic, float maxError) {
+    return radialError(exponent, cubic) <= maxError ||
+        nearestError(exponent, t0, t1, cubic) <= maxError;
+}
+
+// Cubic between two curve points along the curve's tangents there, with the
+// handle lengths fitted by Gauss-Newton steps on the radial residuals. Steps
+// can overshoot where the curve bends sharply, so the best lengths seen are
+// kept.
+Cubic fitArc(double exponent, const CurvePoint& a, const CurvePoint& b) {
+    auto arc = [&a, &b](float la, float lb) {
+        return Cubic(a.point, a.point + a.tangent * la,
+            b.point - b.tangent * lb, b.point);
+    };
+
+    const float chord = (b.point - a.point).getDistance();
+    const float h = chord * FitDerivativeStep;
+    float la = chord / 3.0f;
+    float lb = chord / 3.0f;
+    Cubic best = arc(la, lb);
+    float bestError = radialError(exponent, best);
+
+    Residuals residuals;
+    Residuals movedA;
+    Residuals movedB;
+    for (int iteration = 0; iteration < FitIterations; ++iteration) {
+        radialResiduals(exponent, arc(la, lb), residuals);
+        radialResiduals(exponent, arc(la + h, lb), movedA);
+        radialResiduals(exponent, arc(la, lb + h), movedB);
+
+        // Normal equations of the linearized residuals
+        float aa = 0.0f;
+        float ab = 0.0f;
+        float bb = 0.0f;
+        float ga = 0.0f;
+        float gb = 0.0f;
+        for (size_t i = 0; i < residuals.size(); ++i) {
+            float ja = (movedA[i] - residuals[i]) / h;
+            float jb = (movedB[i] - residuals[i]) / h;
+            aa += ja * ja;
+            ab += ja * jb;
+            bb += jb * jb;
+            ga += ja * residuals[i];
+            gb += jb * residuals[i];
+        }
+        float det = aa * bb - ab * ab;
+        if (!(det > 0.0f)) {
+            // The handles do not move the cubic off the curve, as on a
+            // straight side
+            break;
+        }
+        la = std::max(la - (bb * ga - ab * gb) / det, 0.0f);
+        lb = std::max(lb - (aa * gb - ab * ga) / det, 0.0f);
+
+        Cubic cubic = arc(la, lb);
+        float error = radialError(exponent, cubic);
+        if (error < bestError) {
+            best = cubic;
+            bestError = error;
+        }
+    }
+    return best;
+}
+
+// Fit the curve between parameters t0 and t1, bisecting until each cubic is
+// within maxError of it or the depth runs out
+void fitSuperellipse(double exponent, double t0, double t1,
+    const CurvePoint& a, const CurvePoint& b, float maxError, int depth,
+    std::vector<Cubic>& cubics) {
+    Cubic cubic = fitArc(exponent, a, b);
+    if (depth >= MaxQuadrantDepth ||
+        withinError(exponent, t0, t1, cubic, maxError)) {
+        cubics.push_back(cubic);
+        return;
+    }
+    double tm = (t0 + t1) / 2.0;
+    CurvePoint mid = superellipsePoint(exponent, std::cos(tm), std::sin(tm));
+    fitSuperellipse(exponent, t0, tm, a, mid, maxError, depth + 1, cubics);
+    fitSuperellipse(exponent, tm, t1, mid, b, maxError, depth + 1, cubics);
+}
+
+} // anonymous namespace
+
 RoundedPolygonShape Shapes::circle(
     int numVertices, float radius, float centerX, float centerY) {
     if (numVertices < 3) {
@@ -19,6 +242,79 @@ RoundedPolygonShape Shapes::circle(
         CornerRounding(radius, 0.0f));
 }
 
+RoundedPolygonShape Shapes::ellipse(float radiusX, float radiusY,
+    float maxError, float centerX, float centerY) {
+    return superellipse(2.0f, radiusX, radiusY, maxError, centerX, centerY);
+}
+
+RoundedPolygonShape Shapes::superellipse(float exponent, float radiusX,
+    float radiusY, float maxError, float centerX, float centerY) {
+    if (!(exponent > 0.0f)) {
+        throw std::invalid_argument("Superellipse exponent must be positive");
+    }
+    if (!(radiusX > 0.0f && radiusY > 0.0f)) {
+        throw std::invalid_argument("Superellipse radii must be positive");
+    }
+
+    // The curve is fitted once for the first quadrant of the unit curve,
+    // which the other quadrants are quarter turns of
+    const double n = exponent;
+    const double quarter = std::numbers::pi / 2.0;
+    const float unitError = maxError / std::max(radiusX, radiusY);
+    CurvePoint axisX = superellipsePoint(n, 1.0, 0.0);
+    CurvePoint axisY = superellipsePoint(n, 0.0, 1.0);
+    std::vector<Cubic> quadrant;
+    size_t half = 0;
+    if (exponent < 2.0f) {
+        // Corners sit on the axes, so the quadrant is split at the diagonal
+        // to share it between two of them
+        CurvePoint diagonal = superellipsePoint(
+            n, std::numbers::sqrt2 / 2.0, std::numbers::sqrt2 / 2.0);
+        fitSuperellipse(
+            n, 0.0, quarter / 2.0, axisX, diagonal, unitError, 1, quadrant);
+        half = quadrant.size();
+        fitSuperellipse(
+            n, quarter / 2.0, quarter, diagonal, axisY, unitError, 1, quadrant);
+    } else {
+        fitSuperellipse(n, 0.0, quarter, axisX, axisY, unitError, 0, quadrant);
+    }
+
+    std::vector<Cubic> quadrants[4];
+    for (int turn = 0; turn < 4; ++turn) {
+        quadrants[turn].reserve(quadrant.size());
+        for (const auto& cubic : quadrant) {
+            quadrants[turn].push_back(cubic.transformed(
+                [turn, radiusX, radiusY, centerX, centerY](float x, float y) {
+                    for (int i = 0; i < turn; ++i) {
+                        std::swap(x, y);
+                        x = -x;
+                    }
+                    return TransformResult(
+                        centerX + x * radiusX, centerY + y * radiusY);
+                }));
+        }
+    }
+
+    std::vector<std::unique_ptr<Feature>> features;
+    features.reserve(4);
+    for (int turn = 0; turn < 4; ++turn) {
+        if (half == 0) {
+            features.push_back(Feature::buildConvexCorner(quadrants[turn]));
+            continue;
+        }
+        // The corner on the axis at the start of this quadrant
+        const auto& previous = quadrants[(turn + 3) % 4];
+        std::vector<Cubic> corner(
+            previous.begin() + static_cast<std::ptrdiff_t>(half),
+            previous.end());
+        corner.insert(corner.end(), quadrants[turn].begin(),
+            quadrants[turn].begin() + static_cast<std::ptrdiff_t>(half));
+        features.push_back(Feature::buildConvexCorner(corner));
+    }
+
+    return RoundedPolygonShape(std::move(features), Point(centerX, centerY));
+}
+
 RoundedPolygonShape Shapes::rectangle(float width, float height,
     const CornerRounding& rounding,
     const std::vector<CornerRounding>* perVertexRounding, float centerX,
@@ -59,17 +355,19 @@ RoundedPolygonShape Shapes::star(int numVerticesPerRadius, float radius,
         roundings.resize(totalVertices);
     }
 
+    // Vertices alternate between the outer and inner radius, evenly spaced
+    std::vector<float> cosines(totalVertices);
+    std::vector<float> sines(totalVertices);
+    unitCircle(totalVertices, 0.0,
+        std::numbers::pi / static_cast<double>(numVerticesPerRadius),
+        cosines.data(), sines.data());
+
     for (size_t i = 0; i < totalVertices; ++i) {
-        float angleRadians = FloatPi /
-                             static_cast<float>(numVerticesPerRadius) *
-                             static_cast<float>(i);
         bool isOuter = (i % 2 == 0);
         float r = isOuter ? radius : innerRadius;
 
-        Point vertex =
-            radialToCartesian(r, angleRadians, Point(centerX, centerY));
-        vertices[i * 2] = vertex.x;
-        vertices[i * 2 + 1] = vertex.y;
+        vertices[i * 2] = cosines[i] * r + centerX;
+        vertices[i * 2 + 1] = sines[i] * r + centerY;
 
         if (!hasPerVertexRounding && !roundings.empty()) {
             if (isOuter) {
@@ -142,31 +440,32 @@ RoundedPolygonShape Shapes::pillStar(float width, float height,
         roundings.resize(totalVertices);
     }
 
+    // Outer vertices sit at even multiples of the vertex angle, and inner
+    // vertices at odd multiples shifted by the vertex spacing adjustment
+    const double vertexAngle =
+        2.0 * std::numbers::pi / static_cast<double>(totalVertices);
+    const double startAngle =
+        2.0 * std::numbers::pi * static_cast<double>(startLocation);
+    const size_t perRadius = static_cast<size_t>(numVerticesPerRadius);
+    std::vector<float> cosines(totalVertices);
+    std::vector<float> sines(totalVertices);
+    unitCircle(perRadius, startAngle, vertexAngle * 2.0, cosines.data(),
+        sines.data());
+    unitCircle(perRadius,
+        startAngle + vertexAngle * (0.5 + static_cast<double>(vertexSpacing)),
+        vertexAngle * 2.0, cosines.data() + perRadius,
+        sines.data() + perRadius);
+
     // Calculate vertices with elliptical distribution
     for (size_t i = 0; i < totalVertices; ++i) {
-        float baseAngle =
-            TwoPi / static_cast<float>(totalVertices) * static_cast<float>(i) +
-            startLocation * TwoPi;
         bool isOuter = (i % 2 == 0);
-
-        float w, h;
-        if (isOuter) {
-            w = outerWidth;
-            h = outerHeight;
-        } else {
-            // Apply vertex spacing adjustment for inner vertices
-            float adjustedIndex =
-                static_cast<float>(i) + (vertexSpacing - 0.5f);
-            baseAngle =
-                TwoPi / static_cast<float>(totalVertices) * adjustedIndex +
-                startLocation * TwoPi;
-            w = innerWidth;
-            h = innerHeight;
-        }
+        size_t angleIndex = isOuter ? i / 2 : perRadius + i / 2;
+        float w = isOuter ? outerWidth : innerWidth;
+        float h = isOuter ? outerHeight : innerHeight;
 
         // Elliptical coordinates
-        vertices[i * 2] = centerX + w * std::cos(baseAngle);
-        vertices[i * 2 + 1] = centerY + h * std::sin(baseAngle);
+        vertices[i * 2] = centerX + w * cosines[angleIndex];
+        vertices[i * 2 + 1] = centerY + h * sines[angleIndex];
 
         if (!hasPerVertexRounding && !roundings.empty()) {
             if (isOuter) {
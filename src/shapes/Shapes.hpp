@@ -20,6 +20,47 @@ public:
     [[nodiscard]] static RoundedPolygonShape circle(int numVertices = 8,
         float radius = 1.0f, float centerX = 0.0f, float centerY = 0.0f);
 
+    /**
+     * Creates an ellipse from as few cubics as stay within maxError of it,
+     * four for a circle at the default tolerance. Each quadrant is one convex
+     * corner for morph mapping.
+     *
+     * @param radiusX Horizontal radius
+     * @param radiusY Vertical radius
+     * @param maxError Largest distance allowed between the cubics and the
+     * ellipse
+     * @param centerX X coordinate of center
+     * @param centerY Y coordinate of center
+     */
+    [[nodiscard]] static RoundedPolygonShape ellipse(float radiusX = 1.0f,
+        float radiusY = 1.0f, float maxError = 1e-3f, float centerX = 0.0f,
+        float centerY = 0.0f);
+
+    /**
+     * Creates a superellipse |x / radiusX|^n + |y / radiusY|^n = 1 from as
+     * few cubics as stay within maxError of it, eight for a squircle (n = 4)
+     * at the default tolerance.
+     *
+     * The shape has four convex corners for morph mapping, centered on the
+     * diagonals when n >= 2 and on the axes when n < 2, where the curve is
+     * sharpest.
+     *
+     * Each quarter of the curve takes at most 64 cubics. Exponents below
+     * about 0.1 come to points too sharp for that many at the default
+     * tolerance, and stray further than maxError near the axes.
+     *
+     * @param exponent The exponent n, greater than zero
+     * @param radiusX Horizontal radius
+     * @param radiusY Vertical radius
+     * @param maxError Largest distance allowed between each point of the
+     * cubics and the nearest point of the curve
+     * @param centerX X coordinate of center
+     * @param centerY Y coordinate of center
+     */
+    [[nodiscard]] static RoundedPolygonShape superellipse(float exponent,
+        float radiusX = 1.0f, float radiusY = 1.0f, float maxError = 1e-3f,
+        float centerX = 0.0f, float centerY = 0.0f);
+
     /**
      * Creates a rectangle with optional corner rounding.
      *
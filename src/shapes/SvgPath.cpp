@@ -0,0 +1,430 @@
+#include "SvgPath.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+#include <string>
+
+namespace RoundedPolygon {
+
+namespace {
+
+// Largest sweep of an elliptical arc drawn with a single cubic
+constexpr double MaxArcSweep = std::numbers::pi / 2.0;
+
+// Direction in which a cubic leaves its first anchor, or zero if it has no
+// length. Handles that coincide with their anchor are passed over.
+Point startTangent(const Cubic& cubic) {
+    Point anchor(cubic.anchor0X(), cubic.anchor0Y());
+    for (Point next : { Point(cubic.control0X(), cubic.control0Y()),
+             Point(cubic.control1X(), cubic.control1Y()),
+             Point(cubic.anchor1X(), cubic.anchor1Y()) }) {
+        if ((next - anchor).getDistance() > DistanceEpsilon) {
+            return (next - anchor).getDirection();
+        }
+    }
+    return Point();
+}
+
+// Direction in which a cubic arrives at its second anchor
+Point endTangent(const Cubic& cubic) {
+    return -startTangent(cubic.reverse());
+}
+
+/**
+ * Reads path data one command at a time and collects the cubics of the
+ * current subpath, turning each subpath into a shape when it ends.
+ */
+class PathImporter {
+public:
+    PathImporter(std::string_view data, float cornerAngle,
+        std::vector<RoundedPolygonShape>& shapes)
+        : m_data(data)
+        , m_cornerCos(std::cos(cornerAngle))
+        , m_shapes(shapes) {}
+
+    void run() {
+        char previous = 0;
+        while (!atEnd()) {
+            size_t offset = m_pos;
+            char command = m_data[m_pos++];
+            if (previous == 0 && command != 'M' && command != 'm') {
+                fail(offset);
+            }
+            bool relative = command >= 'a' && command <= 'z';
+            char type = relative ? static_cast<char>(command - 'a' + 'A')
+                                 : command;
+            if (type == 'Z') {
+                closePath();
+            } else {
+                do {
+                    segment(type, relative, previous);
+                    previous = type;
+                    // Coordinates after the first pair of a moveto are
+                    // lines
+                    if (type == 'M') {
+                        type = 'L';
+                    }
+                } while (atNumber());
+            }
+            previous = type;
+        }
+        finishSubpath();
+    }
+
+private:
+    std::string_view m_data;
+    size_t m_pos = 0;
+    const float m_cornerCos;
+    std::vector<RoundedPolygonShape>& m_shapes;
+
+    // Current point and start of the subpath as the path data defines them
+    Point m_current;
+    Point m_start;
+    // Second control point of the last segment, which S and T reflect
+    Point m_control;
+    bool m_open = false;
+    // Cubics of the current subpath, kept between subpaths for their storage
+    std::vector<Cubic> m_cubics;
+
+    [[noreturn]] void fail(size_t offset) const {
+        throw std::invalid_argument(
+            "Invalid SVG path data at offset " + std::to_string(offset));
+    }
+
+    void skipSpace() {
+        while (m_pos < m_data.size() &&
+            (m_data[m_pos] == ' ' || m_data[m_pos] == '\t' ||
+                m_data[m_pos] == '\n' || m_data[m_pos] == '\r' ||
+                m_data[m_pos] == '\f')) {
+            ++m_pos;
+        }
+    }
+
+    bool atEnd() {
+        skipSpace();
+        return m_pos >= m_data.size();
+    }
+
+    // Skip the separator in front of another argument and tell whether one
+    // follows. A single comma may sit between arguments.
+    bool atNumber() {
+        skipSpace();
+        if (m_pos < m_data.size() && m_data[m_pos] == ',') {
+            ++m_pos;
+            skipSpace();
+            if (m_pos >= m_data.size()) {
+                fail(m_pos);
+            }
+        }
+        if (m_pos >= m_data.size()) {
+            return false;
+        }
+        char c = m_data[m_pos];
+        return (c >= '0' && c <= '9') || c == '.' || c == '-' || c == '+';
+    }
+
+    float number() {
+        if (!atNumber()) {
+            fail(m_pos);
+        }
+        size_t offset = m_pos;
+        if (m_data[m_pos] == '+') {
+            ++m_pos;
+        }
+        // std::from_chars would also take inf and nan, which SVG does not
+        size_t digits = m_pos + (m_data[m_pos] == '-' ? 1 : 0);
+        if (digits >= m_data.size() ||
+            !((m_data[digits] >= '0' && m_data[digits] <= '9') ||
+                m_data[digits] == '.')) {
+            fail(offset);
+        }
+        float value = 0.0f;
+        const char* end = m_data.data() + m_data.size();
+        auto [next, error] =
+            std::from_chars(m_data.data() + m_pos, end, value);
+        if (error != std::errc()) {
+            fail(offset);
+        }
+        m_pos = static_cast<size_t>(next - m_data.data());
+        return value;
+    }
+
+    // Arc flags are single digits and need no separator after them
+    bool flag() {
+        if (!atNumber() || (m_data[m_pos] != '0' && m_data[m_pos] != '1')) {
+            fail(m_pos);
+        }
+        return m_data[m_pos++] == '1';
+    }
+
+    Point point(bool relative) {
+        float x = number();
+        float y = number();
+        return relative ? m_current + Point(x, y) : Point(x, y);
+    }
+
+    void segment(char type, bool relative, char previous) {
+        switch (type) {
+        case 'M':
+            finishSubpath();
+            m_current = point(relative);
+            m_start = m_current;
+            m_control = m_current;
+            return;
+        case 'L':
+            lineTo(point(relative));
+            return;
+        case 'H': {
+            float x = number();
+            lineTo(Point(relative ? m_current.x + x : x, m_current.y));
+            return;
+        }
+        case 'V': {
+            float y = number();
+            lineTo(Point(m_current.x, relative ? m_current.y + y : y));
+            return;
+        }
+        case 'C': {
+            Point control0 = point(relative);
+            Point control1 = point(relative);
+            cubicTo(control0, control1, point(relative));
+            return;
+        }
+        case 'S': {
+            Point control0 = previous == 'C' || previous == 'S'
+                ? m_current * 2.0f - m_control
+                : m_current;
+            Point control1 = point(relative);
+            cubicTo(control0, control1, point(relative));
+            return;
+        }
+        case 'Q': {
+            Point control = point(relative);
+            quadTo(control, point(relative));
+            return;
+        }
+        case 'T': {
+            Point control = previous == 'Q' || previous == 'T'
+                ? m_current * 2.0f - m_control
+                : m_current;
+            quadTo(control, point(relative));
+            return;
+        }
+        case 'A': {
+            float radiusX = number();
+            float radiusY = number();
+            float rotation = number();
+            bool largeArc = flag();
+            bool sweep = flag();
+            arcTo(radiusX, radiusY, rotation, largeArc, sweep,
+                point(relative));
+            return;
+        }
+        default:
+            fail(m_pos - 1);
+        }
+    }
+
+    void lineTo(const Point& end) {
+        addCubic(Cubic::straightLine(
+            m_current.x, m_current.y, end.x, end.y));
+        m_control = end;
+        m_current = end;
+    }
+
+    void cubicTo(const Point& control0, const Point& control1,
+        const Point& end) {
+        addCubic(Cubic(m_current, control0, control1, end));
+        m_control = control1;
+        m_current = end;
+    }
+
+    void quadTo(const Point& control, const Point& end) {
+        addCubic(Cubic(m_current,
+            m_current + (control - m_current) * (2.0f / 3.0f),
+            end + (control - end) * (2.0f / 3.0f), end));
+        m_control = control;
+        m_current = end;
+    }
+
+    // Elliptical arc from the current point, converted to center
+    // parameterization as in the SVG implementation notes and drawn with one
+    // cubic per quarter turn at most
+    void arcTo(float radiusX, float radiusY, float rotationDegrees,
+        bool largeArc, bool sweep, const Point& end) {
+        if (end == m_current) {
+            return;
+        }
+        if (std::abs(radiusX) < DistanceEpsilon ||
+            std::abs(radiusY) < DistanceEpsilon) {
+            lineTo(end);
+            return;
+        }
+        double rx = std::abs(static_cast<double>(radiusX));
+        double ry = std::abs(static_cast<double>(radiusY));
+        double phi = static_cast<double>(rotationDegrees) *
+            std::numbers::pi / 180.0;
+        double cosPhi = std::cos(phi);
+        double sinPhi = std::sin(phi);
+
+        // Start point in the frame of the ellipse, halfway to the end
+        double halfX = static_cast<double>(m_current.x - end.x) / 2.0;
+        double halfY = static_cast<double>(m_current.y - end.y) / 2.0;
+        double x1 = cosPhi * halfX + sinPhi * halfY;
+        double y1 = -sinPhi * halfX + cosPhi * halfY;
+
+        // Radii too small to reach the end are scaled up until they do
+        double lambda = (x1 * x1) / (rx * rx) + (y1 * y1) / (ry * ry);
+        if (lambda > 1.0) {
+            rx *= std::sqrt(lambda);
+            ry *= std::sqrt(lambda);
+        }
+
+        double numerator = rx * rx * ry * ry - rx * rx * y1 * y1 -
+            ry * ry * x1 * x1;
+        double denominator = rx * rx * y1 * y1 + ry * ry * x1 * x1;
+        double coefficient = std::sqrt(std::max(0.0, numerator / denominator)) *
+            (largeArc == sweep ? -1.0 : 1.0);
+        double centerX1 = coefficient * rx * y1 / ry;
+        double centerY1 = -coefficient * ry * x1 / rx;
+        double centerX = cosPhi * centerX1 - sinPhi * centerY1 +
+            static_cast<double>(m_current.x + end.x) / 2.0;
+        double centerY = sinPhi * centerX1 + cosPhi * centerY1 +
+            static_cast<double>(m_current.y + end.y) / 2.0;
+
+        double startX = (x1 - centerX1) / rx;
+        double startY = (y1 - centerY1) / ry;
+        double endX = (-x1 - centerX1) / rx;
+        double endY = (-y1 - centerY1) / ry;
+        double startAngle = std::atan2(startY, startX);
+        double sweepAngle = std::atan2(startX * endY - startY * endX,
+            startX * endX + startY * endY);
+        if (!sweep && sweepAngle > 0.0) {
+            sweepAngle -= 2.0 * std::numbers::pi;
+        } else if (sweep && sweepAngle < 0.0) {
+            sweepAngle += 2.0 * std::numbers::pi;
+        }
+
+        int count = std::max(1,
+            static_cast<int>(std::ceil(std::abs(sweepAngle) / MaxArcSweep -
+                static_cast<double>(AngleEpsilon))));
+        double step = sweepAngle / count;
+        double handle = 4.0 / 3.0 * std::tan(step / 4.0);
+
+        // Point on the ellipse at angle t, and its derivative scaled by the
+        // handle length
+        auto at = [&](double t, bool derivative) {
+            double x = derivative ? -rx * std::sin(t) * handle
+                                  : rx * std::cos(t);
+            double y = derivative ? ry * std::cos(t) * handle
+                                  : ry * std::sin(t);
+            double offsetX = derivative ? 0.0 : centerX;
+            double offsetY = derivative ? 0.0 : centerY;
+            return Point(static_cast<float>(cosPhi * x - sinPhi * y + offsetX),
+                static_cast<float>(sinPhi * x + cosPhi * y + offsetY));
+        };
+
+        for (int i = 0; i < count; ++i) {
+            double t0 = startAngle + step * i;
+            double t1 = t0 + step;
+            Point to = i + 1 == count ? end : at(t1, false);
+            addCubic(Cubic(m_current, m_current + at(t0, true),
+                to - at(t1, true), to));
+            m_current = to;
+        }
+        m_control = end;
+    }
+
+    void closePath() {
+        if (m_open) {
+            lineTo(m_start);
+            finishSubpath();
+        }
+        // A segment after the close starts a new subpath at the same point
+        m_current = m_start;
+        m_control = m_start;
+    }
+
+    void addCubic(const Cubic& cubic) {
+        m_open = true;
+        if (!cubic.zeroLength()) {
+            m_cubics.push_back(cubic);
+        }
+    }
+
+    // Close the current subpath and add its shape
+    void finishSubpath() {
+        m_open = false;
+        if (m_cubics.empty()) {
+            return;
+        }
+        Point start(m_cubics.front().anchor0X(), m_cubics.front().anchor0Y());
+        Point last(m_cubics.back().anchor1X(), m_cubics.back().anchor1Y());
+        if ((last - start).getDistance() > DistanceEpsilon) {
+            m_cubics.push_back(
+                Cubic::straightLine(last.x, last.y, start.x, start.y));
+        }
+        const size_t n = m_cubics.size();
+
+        // Twice the signed area of the control polygon, whose sign is the
+        // direction the subpath runs
+        float area = 0.0f;
+        for (const auto& cubic : m_cubics) {
+            const auto& p = cubic.points();
+            for (size_t i = 0; i < 6; i += 2) {
+                area += p[i] * p[i + 3] - p[i + 2] * p[i + 1];
+            }
+        }
+        if (area < 0.0f) {
+            std::reverse(m_cubics.begin(), m_cubics.end());
+            for (auto& cubic : m_cubics) {
+                cubic = cubic.reverse();
+            }
+        }
+
+        std::vector<std::unique_ptr<Feature>> features;
+        features.reserve(n * 2);
+        Point center;
+        for (size_t i = 0; i < n; ++i) {
+            const Cubic& cubic = m_cubics[i];
+            Point tangentIn = endTangent(m_cubics[(i + n - 1) % n]);
+            Point tangentOut = startTangent(cubic);
+            if (tangentIn.dotProduct(tangentOut) < m_cornerCos) {
+                std::vector<Cubic> corner{ Cubic::empty(
+                    cubic.anchor0X(), cubic.anchor0Y()) };
+                features.push_back(tangentIn.clockwise(tangentOut)
+                        ? Feature::buildConvexCorner(corner)
+                        : Feature::buildConcaveCorner(corner));
+            }
+            features.push_back(Feature::buildEdge(cubic));
+            center += Point(cubic.anchor0X(), cubic.anchor0Y());
+        }
+        m_shapes.emplace_back(
+            std::move(features), center / static_cast<float>(n));
+        m_cubics.clear();
+    }
+};
+
+} // anonymous namespace
+
+std::vector<RoundedPolygonShape> SvgPath::shapes(
+    std::string_view pathData, float cornerAngle) {
+    std::vector<RoundedPolygonShape> result;
+    PathImporter(pathData, cornerAngle, result).run();
+    return result;
+}
+
+RoundedPolygonShape SvgPath::shape(
+    std::string_view pathData, float cornerAngle) {
+    std::vector<RoundedPolygonShape> result = shapes(pathData, cornerAngle);
+    if (result.size() != 1) {
+        throw std::invalid_argument(
+            "SVG path data must have exactly one subpath, not " +
+            std::to_string(result.size()));
+    }
+    return std::move(result.front());
+}
+
+} // namespace RoundedPolygon
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "core/RoundedPolygon.hpp"
+#include <string_view>
+#include <vector>
+
+namespace RoundedPolygon {
+
+/**
+ * Imports SVG path data, the d attribute of a path element, as shapes that
+ * can be morphed. All commands are supported in their absolute and relative
+ * forms; lines, quadratic curves and elliptical arcs become cubics.
+ *
+ * Each subpath becomes one closed shape, turned if needed to run the same way
+ * as the shapes built from vertices. Every segment is an edge of it, and a
+ * sharp corner is placed wherever the tangent turns by more than cornerAngle
+ * radians between two segments, convex or concave by the way it turns.
+ *
+ * The data is read in place, and malformed data throws
+ * std::invalid_argument naming the offset where it goes wrong.
+ */
+class SvgPath {
+public:
+    // Turn of the tangent between two segments that makes a corner, which
+    // allows for smooth joins rounded to a couple of decimals
+    static constexpr float DefaultCornerAngle = FloatPi / 18.0f;
+
+    /**
+     * One shape per subpath of pathData, in order. Subpaths that enclose
+     * nothing, such as a lone moveto, are skipped.
+     */
+    [[nodiscard]] static std::vector<RoundedPolygonShape> shapes(
+        std::string_view pathData, float cornerAngle = DefaultCornerAngle);
+
+    /**
+     * The shape of pathData, which must have exactly one subpath.
+     */
+    [[nodiscard]] static RoundedPolygonShape shape(
+        std::string_view pathData, float cornerAngle = DefaultCornerAngle);
+
+private:
+    SvgPath() = default;
+};
+
+} // namespace RoundedPolygon
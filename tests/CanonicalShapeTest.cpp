@@ -0,0 +1,115 @@
+#include "Check.hpp"
+#include "morph/Morph.hpp"
+#include "morph/PreparedShape.hpp"
+#include "shapes/MaterialShapes.hpp"
+#include <cmath>
+#include <memory>
+#include <vector>
+
+using namespace RoundedPolygon;
+
+namespace {
+
+constexpr size_t CubicCounts[] = { 1, 2, 3, 7, 16, 64, 300 };
+
+bool near(float a, float b, float tolerance) {
+    return std::abs(a - b) <= tolerance;
+}
+
+// Whether the cubics join into one closed outline
+bool closed(const std::vector<Cubic>& cubics) {
+    for (size_t i = 0; i < cubics.size(); ++i) {
+        const Cubic& cubic = cubics[i];
+        const Cubic& next = cubics[(i + 1) % cubics.size()];
+        if (!near(cubic.anchor1X(), next.anchor0X(), 1e-3f) ||
+            !near(cubic.anchor1Y(), next.anchor0Y(), 1e-3f)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Whether every feature of shape starts where a canonical cubic starts, so
+// no canonical cubic spans two features. Features shorter than the tolerance
+// are dropped when measuring, and count as points.
+bool keepsFeatures(
+    const RoundedPolygonShape& shape, const std::vector<Cubic>& cubics) {
+    for (const auto& feature : shape.features()) {
+        const Cubic& first = feature->cubics().front();
+        bool found = false;
+        for (const auto& cubic : cubics) {
+            found = found ||
+                (near(cubic.anchor0X(), first.anchor0X(), 1e-3f) &&
+                    near(cubic.anchor0Y(), first.anchor0Y(), 1e-3f));
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void testMaterialShapes() {
+    for (size_t i = 0; i < MaterialShapes::ShapeTypeCount; ++i) {
+        const auto shape = PreparedShape::prepare(*MaterialShapes::getShape(
+            static_cast<MaterialShapes::ShapeType>(i)));
+        for (size_t count : CubicCounts) {
+            const auto& cubics = shape->canonical(count).cubics();
+            CHECK(cubics.size() == count);
+            CHECK(closed(cubics));
+            // The anchor corner is cut in two, so it needs two cubics
+            if (count > shape->shape().features().size()) {
+                CHECK(keepsFeatures(shape->shape(), cubics));
+            }
+        }
+    }
+}
+
+// Corners at the same place along two outlines get the same cubics, so a
+// polygon and a larger copy of it resample alike
+void testPlacement() {
+    for (int vertices = 3; vertices <= 8; ++vertices) {
+        const auto small = PreparedShape::prepare(RoundedPolygonShape(
+            vertices, 1.0f, 0.0f, 0.0f, CornerRounding(0.2f)));
+        const auto large = PreparedShape::prepare(RoundedPolygonShape(
+            vertices, 3.0f, 0.0f, 0.0f, CornerRounding(0.6f)));
+        const auto& smallCubics = small->canonical(40).cubics();
+        const auto& largeCubics = large->canonical(40).cubics();
+        CHECK(keepsFeatures(small->shape(), smallCubics));
+        bool scaled = smallCubics.size() == largeCubics.size();
+        for (size_t i = 0; scaled && i < smallCubics.size(); ++i) {
+            for (size_t j = 0; j < 8; ++j) {
+                scaled = scaled &&
+                    near(smallCubics[i].points()[j] * 3.0f,
+                        largeCubics[i].points()[j], 1e-3f);
+            }
+        }
+        CHECK(scaled);
+    }
+}
+
+void testCanonicalMorph() {
+    const auto start = PreparedShape::prepare(RoundedPolygonShape(4));
+    const auto end = PreparedShape::prepare(
+        *MaterialShapes::getShape(MaterialShapes::ShapeType::Cookie9Sided));
+    const Morph morph = Morph::canonical(start, end, 32);
+    CHECK(morph.morphMatch().size() == 32);
+    for (size_t i = 0; i < morph.morphMatch().size(); ++i) {
+        const auto& [startCubic, endCubic] = morph.morphMatch()[i];
+        const Cubic& startExpected = start->canonical(32).cubics()[i];
+        const Cubic& endExpected = end->canonical(32).cubics()[i];
+        for (size_t j = 0; j < 8; ++j) {
+            CHECK(near(startCubic.points()[j], startExpected.points()[j], 0) &&
+                near(endCubic.points()[j], endExpected.points()[j], 0));
+        }
+    }
+}
+
+} // anonymous namespace
+
+int main() {
+    testMaterialShapes();
+    testPlacement();
+    testCanonicalMorph();
+    return Check::result();
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdio>
+#include <exception>
+
+// Minimal checks for the unit tests. A failed check is reported and the
+// test carries on; the test fails if any check failed.
+
+namespace Check {
+
+inline int failures = 0;
+
+inline void fail(const char* file, int line, const char* what) {
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what);
+    ++failures;
+}
+
+// Exit code of a test that ran its checks
+inline int result() {
+    if (failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace Check
+
+#define CHECK(condition)                                                       \
+    do {                                                                       \
+        if (!(condition)) {                                                    \
+            Check::fail(__FILE__, __LINE__, #condition);                       \
+        }                                                                      \
+    } while (false)
+
+#define CHECK_THROWS(statement, type)                                          \
+    do {                                                                       \
+        bool thrown = false;                                                   \
+        try {                                                                  \
+            statement;                                                         \
+        } catch (const type&) {                                                \
+            thrown = true;                                                     \
+        } catch (const std::exception&) {                                      \
+        }                                                                      \
+        if (!thrown) {                                                         \
+            Check::fail(__FILE__, __LINE__, #statement " throws " #type);      \
+        }                                                                      \
+    } while (false)
@@ -0,0 +1,262 @@
+#include "Check.hpp"
+#include "morph/MorphDiskCache.hpp"
+#include "morph/PreparedShape.hpp"
+#include "shapes/MaterialShapes.hpp"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace RoundedPolygon;
+
+namespace {
+
+// Offsets into the cache format, see MorphDiskCache.cpp
+constexpr size_t FormatVersionOffset = 4;
+constexpr size_t LibraryVersionOffset = 8;
+constexpr size_t HeaderSize = 32;
+constexpr size_t FirstPairOffset = HeaderSize + 16;
+constexpr size_t EntryRecordSize = 40;
+
+std::shared_ptr<const PreparedShape> material(MaterialShapes::ShapeType type) {
+    return PreparedShape::prepare(*MaterialShapes::getShape(type));
+}
+
+// The shape of type stretched horizontally by 1 + step / 1000, giving any
+// number of distinct shapes
+std::shared_ptr<const PreparedShape> stretched(
+    MaterialShapes::ShapeType type, size_t step) {
+    const float scale = 1.0f + static_cast<float>(step) * 1e-3f;
+    return PreparedShape::prepare(MaterialShapes::getShape(type)->transformed(
+        [scale](float x, float y) { return TransformResult(x * scale, y); }));
+}
+
+bool sameCubics(const Cubic& a, const Cubic& b) {
+    return std::memcmp(a.points().data(), b.points().data(),
+               sizeof(float) * a.points().size()) == 0;
+}
+
+bool sameMatch(const Morph& a, const Morph& b) {
+    const auto& matchA = a.morphMatch();
+    const auto& matchB = b.morphMatch();
+    if (matchA.size() != matchB.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < matchA.size(); ++i) {
+        if (!sameCubics(matchA[i].first, matchB[i].first) ||
+            !sameCubics(matchA[i].second, matchB[i].second)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<char> readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return { std::istreambuf_iterator<char>(file),
+        std::istreambuf_iterator<char>() };
+}
+
+void writeFile(const std::string& path, const std::vector<char>& data) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+void testRoundTrip(const std::string& path) {
+    auto heart = material(MaterialShapes::ShapeType::Heart);
+    auto sunny = material(MaterialShapes::ShapeType::Sunny);
+    auto pill = material(MaterialShapes::ShapeType::Pill);
+    const Morph heartToSunny(heart, sunny);
+    const Morph sunnyToPill(sunny, pill);
+    const Morph swapped = Morph(pill, heart).transformed(
+        {}, [](float x, float y) { return TransformResult(y, x); });
+    {
+        MorphDiskCache cache(path);
+        CHECK(!cache.find(heart, sunny));
+        cache.insert(heartToSunny);
+        auto found = cache.find(heart, sunny);
+        CHECK(found && sameMatch(*found, heartToSunny));
+        cache.flush();
+        CHECK(std::filesystem::exists(path));
+
+        // Written by the destructor
+        cache.insert(sunnyToPill);
+        cache.insert(Morph::canonical(heart, pill));
+        cache.insert(swapped);
+    }
+
+    MorphDiskCache cache(path);
+    auto found = cache.find(heart, sunny);
+    CHECK(found && sameMatch(*found, heartToSunny));
+    found = cache.find(sunny, pill);
+    CHECK(found && sameMatch(*found, sunnyToPill));
+    CHECK(!cache.find(sunny, heart));
+    CHECK(!cache.find(heart, pill));
+    CHECK(!cache.find(swapped.start(), swapped.end()));
+
+    // A found morph keeps what update() needs
+    auto edited = stretched(MaterialShapes::ShapeType::Sunny, 10);
+    found = cache.find(heart, sunny);
+    Morph fresh(heart, sunny);
+    CHECK(found && found->update(heart, edited));
+    CHECK(fresh.update(heart, edited));
+    CHECK(found && sameMatch(*found, fresh));
+}
+
+void testBackgroundWrite(const std::string& path) {
+    auto start = material(MaterialShapes::ShapeType::Clover4Leaf);
+    auto end = material(MaterialShapes::ShapeType::Gem);
+    MorphDiskCache cache(path);
+    cache.insert(Morph(start, end));
+
+    const auto deadline = std::chrono::steady_clock::now() +
+        MorphDiskCache::WriteDelay * 5;
+    while (!std::filesystem::exists(path) &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(MorphDiskCache::WriteDelay / 10);
+    }
+    CHECK(std::filesystem::exists(path));
+    CHECK(MorphDiskCache(path).find(start, end).has_value());
+}
+
+void testCapacity(const std::string& path) {
+    auto end = material(MaterialShapes::ShapeType::Cookie9Sided);
+    const size_t extra = 8;
+    std::vector<std::shared_ptr<const PreparedShape>> starts;
+    for (size_t i = 0; i < MorphDiskCache::Capacity + extra; ++i) {
+        starts.push_back(stretched(MaterialShapes::ShapeType::Square, i));
+    }
+    {
+        MorphDiskCache cache(path);
+        for (const auto& start : starts) {
+            cache.insert(Morph(start, end));
+        }
+        // The least recently used entries were dropped
+        CHECK(!cache.find(starts.front(), end));
+        CHECK(cache.find(starts[extra], end).has_value());
+        CHECK(cache.find(starts.back(), end).has_value());
+    }
+
+    MorphDiskCache cache(path);
+    size_t found = 0;
+    for (const auto& start : starts) {
+        if (cache.find(start, end)) {
+            ++found;
+        }
+    }
+    CHECK(found == MorphDiskCache::Capacity);
+    CHECK(!cache.find(starts[extra - 1], end));
+}
+
+// Damaged files and files of other versions are ignored, and replaced by the
+// next write
+void testDamagedFiles(const std::string& path) {
+    auto start = material(MaterialShapes::ShapeType::Flower);
+    auto end = material(MaterialShapes::ShapeType::Puffy);
+    const Morph morph(start, end);
+    {
+        MorphDiskCache cache(path);
+        cache.insert(morph);
+    }
+    const std::vector<char> valid = readFile(path);
+    CHECK(valid.size() > HeaderSize);
+
+    auto ignored = [&](const std::vector<char>& data) {
+        writeFile(path, data);
+        MorphDiskCache cache(path);
+        return !cache.find(start, end).has_value();
+    };
+    CHECK(!ignored(valid));
+
+    for (size_t size : { size_t{ 0 }, size_t{ 4 }, HeaderSize - 1, HeaderSize,
+             valid.size() / 2, valid.size() - 1 }) {
+        CHECK(ignored(std::vector<char>(valid.begin(),
+            valid.begin() + static_cast<std::ptrdiff_t>(size))));
+    }
+
+    std::vector<char> extended = valid;
+    extended.push_back(0);
+    CHECK(ignored(extended));
+
+    std::vector<char> badMagic = valid;
+    badMagic[0] = 'X';
+    CHECK(ignored(badMagic));
+
+    std::vector<char> otherFormat = valid;
+    ++otherFormat[FormatVersionOffset];
+    CHECK(ignored(otherFormat));
+
+    std::vector<char> otherLibrary = valid;
+    ++otherLibrary[LibraryVersionOffset];
+    CHECK(ignored(otherLibrary));
+
+    // An entry whose pairs run past the end of the pair table
+    std::vector<char> badEntry = valid;
+    const uint32_t firstPair = 0xfffffff0u;
+    std::memcpy(&badEntry[FirstPairOffset], &firstPair, sizeof(uint32_t));
+    CHECK(ignored(badEntry));
+
+    // A source naming a cubic the shape does not have loses the sources of
+    // its entry, which must stay lost when the file is written again
+    std::vector<char> badSource = valid;
+    const size_t sourcesOffset = HeaderSize + EntryRecordSize +
+        2 * sizeof(Cubic) * morph.morphMatch().size();
+    const uint32_t badCubic = 0xffffffffu;
+    std::memcpy(&badSource[sourcesOffset + sizeof(uint32_t)], &badCubic,
+        sizeof(uint32_t));
+    writeFile(path, badSource);
+    auto edited = stretched(MaterialShapes::ShapeType::Puffy, 10);
+    {
+        MorphDiskCache cache(path);
+        auto found = cache.find(start, end);
+        CHECK(found && sameMatch(*found, morph));
+        CHECK(found && !found->update(start, edited));
+        cache.insert(Morph(end, start));
+    }
+    {
+        MorphDiskCache cache(path);
+        auto found = cache.find(start, end);
+        CHECK(found && sameMatch(*found, morph));
+        CHECK(found && !found->update(start, edited));
+    }
+
+    {
+        MorphDiskCache cache(path);
+        cache.insert(morph);
+    }
+    MorphDiskCache cache(path);
+    auto found = cache.find(start, end);
+    CHECK(found && sameMatch(*found, morph));
+}
+
+void testUnwritablePath(const std::filesystem::path& directory) {
+    const std::string blocker = (directory / "file").string();
+    writeFile(blocker, { 'x' });
+    MorphDiskCache cache(blocker + "/cache");
+    auto start = material(MaterialShapes::ShapeType::Arch);
+    auto end = material(MaterialShapes::ShapeType::Fan);
+    cache.insert(Morph(start, end));
+    cache.flush();
+    CHECK(cache.find(start, end).has_value());
+}
+
+} // anonymous namespace
+
+int main() {
+    const std::filesystem::path directory =
+        std::filesystem::temp_directory_path() / "m3shapes_morph_cache_test";
+    std::filesystem::remove_all(directory);
+
+    testRoundTrip((directory / "round_trip" / "morphs.cache").string());
+    testBackgroundWrite((directory / "background.cache").string());
+    testCapacity((directory / "capacity.cache").string());
+    testDamagedFiles((directory / "damaged.cache").string());
+    testUnwritablePath(directory);
+
+    std::filesystem::remove_all(directory);
+    return Check::result();
+}
@@ -0,0 +1,266 @@
+#include "Check.hpp"
+#include "core/PolygonBuilder.hpp"
+#include "core/Utils.hpp"
+#include "morph/FeatureMapping.hpp"
+#include "morph/Morph.hpp"
+#include "morph/MorphMatcher.hpp"
+#include "morph/PreparedShape.hpp"
+#include "shapes/MaterialShapes.hpp"
+#include "shapes/Shapes.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace RoundedPolygon;
+
+namespace {
+
+using ShapePair = std::pair<std::shared_ptr<const PreparedShape>,
+    std::shared_ptr<const PreparedShape>>;
+
+std::shared_ptr<const PreparedShape> material(size_t index) {
+    return PreparedShape::prepare(*MaterialShapes::getShape(
+        static_cast<MaterialShapes::ShapeType>(
+            index % MaterialShapes::ShapeTypeCount)));
+}
+
+// Every built-in shape morphing to a few others and to itself, and pairs of
+// shapes with the same features
+std::vector<ShapePair> shapePairs() {
+    constexpr size_t Steps[] = { 0, 1, 7, 20 };
+    std::vector<ShapePair> pairs;
+    for (size_t i = 0; i < MaterialShapes::ShapeTypeCount; ++i) {
+        for (size_t step : Steps) {
+            pairs.emplace_back(material(i), material(i + step));
+        }
+    }
+    pairs.emplace_back(PreparedShape::prepare(RoundedPolygonShape(5)),
+        PreparedShape::prepare(RoundedPolygonShape(5, 2.0f, 1.0f, -1.0f)));
+    // Large enough for measuring and mapping to take many steps each
+    pairs.emplace_back(PreparedShape::prepare(RoundedPolygonShape(
+                           97, 1.0f, 0.0f, 0.0f, CornerRounding(0.01f))),
+        PreparedShape::prepare(Shapes::star(
+            60, 1.0f, 0.7f, CornerRounding(0.02f))));
+    return pairs;
+}
+
+// A seven-pointed star with rounded corners
+PolygonBuilder roundedStar() {
+    std::vector<float> vertices;
+    for (int i = 0; i < 7; ++i) {
+        const float angle = TwoPi * static_cast<float>(i) / 7.0f;
+        const float radius = i % 2 == 0 ? 1.0f : 0.6f;
+        vertices.push_back(radius * std::cos(angle));
+        vertices.push_back(radius * std::sin(angle));
+    }
+    return PolygonBuilder(vertices, CornerRounding(0.15f));
+}
+
+bool sameCubics(const Cubic& a, const Cubic& b) {
+    return std::memcmp(a.points().data(), b.points().data(),
+               sizeof(float) * a.points().size()) == 0;
+}
+
+bool sameMatch(const Morph& a, const Morph& b) {
+    const auto& matchA = a.morphMatch();
+    const auto& matchB = b.morphMatch();
+    if (matchA.size() != matchB.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < matchA.size(); ++i) {
+        if (!sameCubics(matchA[i].first, matchB[i].first) ||
+            !sameCubics(matchA[i].second, matchB[i].second)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Whether two matches pair the same number of cubics, with points no farther
+// apart than tolerance
+bool closeMatch(const Morph& a, const Morph& b, float tolerance) {
+    if (a.morphMatch().size() != b.morphMatch().size()) {
+        return false;
+    }
+    float distance = 0.0f;
+    for (size_t i = 0; i < a.morphMatch().size(); ++i) {
+        const auto& [startA, endA] = a.morphMatch()[i];
+        const auto& [startB, endB] = b.morphMatch()[i];
+        for (size_t j = 0; j < startA.points().size(); ++j) {
+            distance = std::max({ distance,
+                std::abs(startA.points()[j] - startB.points()[j]),
+                std::abs(endA.points()[j] - endB.points()[j]) });
+        }
+    }
+    return distance <= tolerance;
+}
+
+// Whether each side of the match is one closed outline
+bool closedOutlines(const Morph& morph) {
+    const auto& match = morph.morphMatch();
+    for (size_t i = 0; i < match.size(); ++i) {
+        const auto& [start, end] = match[i];
+        const auto& [nextStart, nextEnd] = match[(i + 1) % match.size()];
+        if (std::hypot(start.anchor1X() - nextStart.anchor0X(),
+                start.anchor1Y() - nextStart.anchor0Y()) > DistanceEpsilon ||
+            std::hypot(end.anchor1X() - nextEnd.anchor0X(),
+                end.anchor1Y() - nextEnd.anchor0Y()) > DistanceEpsilon) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// reset() reuses the match of another morph, and must leave nothing of it
+void testReset() {
+    const auto pairs = shapePairs();
+    Morph morph(pairs.back().first, pairs.back().second);
+    for (const auto& [start, end] : pairs) {
+        const Morph fresh(start, end);
+        CHECK(!fresh.morphMatch().empty());
+        morph.reset(start, end);
+        CHECK(sameMatch(morph, fresh));
+        CHECK(morph.start() == start && morph.end() == end);
+    }
+
+    // A copy makes its own matcher and leaves the original as it was
+    Morph copy = morph;
+    const auto& [firstStart, firstEnd] = pairs.front();
+    copy.reset(firstStart, firstEnd);
+    CHECK(sameMatch(copy, Morph(firstStart, firstEnd)));
+    CHECK(sameMatch(morph, Morph(pairs.back().first, pairs.back().second)));
+
+    Morph fromShapes(pairs.front().first, pairs.front().second);
+    for (size_t i = 0; i < pairs.size(); i += 5) {
+        const auto& [start, end] = pairs[i];
+        fromShapes.reset(start->shape(), end->shape());
+        CHECK(sameMatch(fromShapes, Morph(start, end)));
+    }
+}
+
+// Matching in steps, however they are sliced, and after cancelling another
+// match, must give the match Morph computes in one go
+void testMatcher() {
+    const auto pairs = shapePairs();
+    MorphMatcher matcher;
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        const auto& [start, end] = pairs[i];
+        const Morph fresh(start, end);
+
+        matcher.reset(start, end);
+        CHECK_THROWS((void)matcher.takeMorph(), std::logic_error);
+        size_t steps = 0;
+        while (!matcher.advance(1)) {
+            ++steps;
+        }
+        CHECK(matcher.done());
+        CHECK(sameMatch(matcher.takeMorph(), fresh));
+
+        // Cancel part way through another match
+        const auto& [otherStart, otherEnd] = pairs[(i + 1) % pairs.size()];
+        matcher.reset(otherStart, otherEnd);
+        (void)matcher.advance(steps / 2);
+        matcher.reset(start, end);
+        while (!matcher.advanceFor(std::chrono::microseconds(50))) {
+        }
+        CHECK(sameMatch(matcher.takeMorph(), fresh));
+
+        MorphMatcher oneGo(start, end);
+        oneGo.run();
+        CHECK(sameMatch(oneGo.takeMorph(), fresh));
+    }
+}
+
+// Mapping features one unit of work at a time must give the mapping made in
+// one go, and take at least one unit per pair of corners
+void testFeatureMapper() {
+    const auto pairs = shapePairs();
+    IncrementalFeatureMapper stepwise;
+    for (const auto& [start, end] : pairs) {
+        const DoubleMapper expected =
+            featureMapper(start->corners(), end->corners());
+        stepwise.reset(start->corners(), end->corners());
+        size_t steps = 0;
+        while (!stepwise.advance(1)) {
+            ++steps;
+        }
+        CHECK(steps + 1 >= start->corners().size() * end->corners().size());
+        const DoubleMapper mapper = stepwise.mapper();
+        for (int i = 0; i <= 20; ++i) {
+            const float progress = static_cast<float>(i) / 20.0f;
+            CHECK(std::abs(mapper.map(progress) - expected.map(progress)) <=
+                0.0f);
+        }
+    }
+}
+
+// update() cuts the previous match again from edited shapes. It must give
+// back a fresh morph's match for unedited shapes, up to rounding, stay close
+// to it for small edits, and refuse shapes with other features.
+void testUpdate() {
+    // Cutting a cubic once at a composed parameter rounds differently from
+    // cutting it in turn
+    constexpr float Rounding = 1e-5f;
+    // Matching edited shapes afresh cuts them at slightly other places
+    constexpr float SmallEdit = 1e-2f;
+
+    PolygonBuilder builder = roundedStar();
+    const auto star = PreparedShape::prepare(builder.shape());
+    const auto cookie = material(
+        static_cast<size_t>(MaterialShapes::ShapeType::Cookie9Sided));
+    const Morph fresh(star, cookie);
+
+    Morph morph(star, cookie);
+    CHECK(morph.update(star, cookie));
+    CHECK(sameMatch(morph, fresh));
+    CHECK(morph.update(PreparedShape::prepare(star->shape()),
+        PreparedShape::prepare(cookie->shape())));
+    CHECK(closeMatch(morph, fresh, Rounding));
+
+    // Small edits of either shape, in turn
+    for (int i = 1; i <= 3; ++i) {
+        builder.setVertex(2, Point(builder.vertex(2).x + 0.01f,
+                                 builder.vertex(2).y - 0.005f));
+        const auto edited = PreparedShape::prepare(builder.shape());
+        CHECK(morph.update(edited, cookie));
+        CHECK(closedOutlines(morph));
+        const Morph editedFresh(edited, cookie);
+        CHECK(closeMatch(morph, editedFresh, SmallEdit));
+
+        Morph reversed = fresh.reversed();
+        CHECK(reversed.update(cookie, edited));
+        CHECK(closedOutlines(reversed));
+    }
+
+    // Cut again from the original shapes, the match is the original one
+    CHECK(morph.update(star, cookie));
+    CHECK(closeMatch(morph, fresh, Rounding));
+
+    // Other features leave the morph as it was
+    const Morph before = morph;
+    const auto square = PreparedShape::prepare(RoundedPolygonShape(4));
+    CHECK(!morph.update(square, cookie));
+    CHECK(!morph.update(star, square));
+    CHECK(sameMatch(morph, before));
+
+    // Canonical morphs have no sources to cut from
+    Morph canonical = Morph::canonical(star, cookie);
+    const Morph canonicalBefore = canonical;
+    CHECK(!canonical.update(PreparedShape::prepare(star->shape()), cookie));
+    CHECK(sameMatch(canonical, canonicalBefore));
+}
+
+} // anonymous namespace
+
+int main() {
+    testReset();
+    testMatcher();
+    testFeatureMapper();
+    testUpdate();
+    return Check::result();
+}
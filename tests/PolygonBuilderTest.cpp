@@ -0,0 +1,127 @@
+#include "Check.hpp"
+#include "core/OutlineShape.hpp"
+#include "core/PolygonBuilder.hpp"
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+using namespace RoundedPolygon;
+
+namespace {
+
+bool sameCubics(const std::vector<Cubic>& a, const std::vector<Cubic>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::memcmp(a[i].points().data(), b[i].points().data(),
+                sizeof(float) * a[i].points().size()) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The shape the vertex constructor builds from the builder's current
+// vertices and roundings
+RoundedPolygonShape rebuilt(const PolygonBuilder& builder) {
+    std::vector<float> vertices;
+    std::vector<CornerRounding> roundings;
+    for (size_t i = 0; i < builder.size(); ++i) {
+        vertices.push_back(builder.vertex(i).x);
+        vertices.push_back(builder.vertex(i).y);
+        roundings.push_back(builder.rounding(i));
+    }
+    return RoundedPolygonShape(
+        vertices, CornerRounding::Unrounded, &roundings);
+}
+
+void checkBuilder(const PolygonBuilder& builder) {
+    const RoundedPolygonShape expected = rebuilt(builder);
+    const RoundedPolygonShape shape = builder.shape();
+    CHECK(sameCubics(shape.cubics(), expected.cubics()));
+    CHECK(shape.features().size() == expected.features().size());
+    CHECK(std::abs(builder.center().x - expected.centerX()) < 1e-6f &&
+        std::abs(builder.center().y - expected.centerY()) < 1e-6f);
+
+    std::vector<Cubic> outline;
+    builder.outline(outline);
+    CHECK(sameCubics(outline, shape.cubics()));
+}
+
+// Editing one vertex or rounding at a time rebuilds only the geometry around
+// it, which must give the shape built from scratch after every edit,
+// including edits that make corners concave and edits that wrap around
+void testEdits(size_t vertexCount) {
+    std::vector<float> vertices;
+    for (size_t i = 0; i < vertexCount; ++i) {
+        const float angle =
+            TwoPi * static_cast<float>(i) / static_cast<float>(vertexCount);
+        vertices.push_back(std::cos(angle));
+        vertices.push_back(std::sin(angle));
+    }
+    PolygonBuilder builder(vertices, CornerRounding(0.2f, 0.5f));
+    checkBuilder(builder);
+
+    for (size_t edit = 0; edit < 3 * vertexCount; ++edit) {
+        const size_t index = (edit * 5 + 1) % vertexCount;
+        if (edit % 3 == 2) {
+            builder.setRounding(index,
+                CornerRounding(0.05f * static_cast<float>(edit % 7),
+                    0.1f * static_cast<float>(edit % 4)));
+        } else {
+            const Point vertex = builder.vertex(index);
+            const float scale = edit % 2 == 0 ? 0.4f : 1.3f;
+            builder.setVertex(index, Point(vertex.x * scale, vertex.y * scale));
+        }
+        checkBuilder(builder);
+    }
+
+    CHECK_THROWS(builder.setVertex(vertexCount, Point(0.0f, 0.0f)),
+        std::out_of_range);
+    CHECK_THROWS(builder.setRounding(vertexCount, CornerRounding::Unrounded),
+        std::out_of_range);
+}
+
+bool sameBounds(
+    const std::array<float, 4>& a, const std::array<float, 4>& b) {
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::abs(a[i] - b[i]) > 1e-5f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// An outline has the bounds of the full shape it builds, transformed or not
+void testOutlineBounds(size_t vertexCount) {
+    const OutlineShape outline(static_cast<int>(vertexCount), 1.0f, 0.2f,
+        -0.1f, CornerRounding(0.3f, 0.4f));
+    const OutlineShape moved =
+        outline
+            .transformed([](float x, float y) {
+                return TransformResult(2.0f * x + 0.5f * y, y - 0.3f);
+            })
+            .normalized();
+    for (const OutlineShape* shape : { &outline, &moved }) {
+        const RoundedPolygonShape full = shape->shape();
+        CHECK(sameBounds(shape->calculateBounds(), full.calculateBounds()));
+        CHECK(sameBounds(
+            shape->calculateBounds(false), full.calculateBounds(false)));
+        CHECK(sameBounds(
+            shape->calculateMaxBounds(), full.calculateMaxBounds()));
+    }
+}
+
+} // anonymous namespace
+
+int main() {
+    constexpr size_t VertexCounts[] = { 3, 4, 5, 8, 13 };
+    for (size_t vertexCount : VertexCounts) {
+        testEdits(vertexCount);
+        testOutlineBounds(vertexCount);
+    }
+    return Check::result();
+}
@@ -0,0 +1,226 @@
+#include "Check.hpp"
+#include "core/Utils.hpp"
+#include "shapes/MaterialShapes.hpp"
+#include "shapes/Shapes.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <vector>
+
+using namespace RoundedPolygon;
+
+namespace {
+
+// Largest distance allowed between a vertex and the one computed with
+// std::cos and std::sin in double precision, for shapes of radius about 1.
+// Float rounding of the coordinates alone is about 1e-7.
+constexpr float Tolerance = 2e-6f;
+
+constexpr double Pi = std::numbers::pi;
+
+Point polar(double angle, double radiusX, double radiusY, const Point& center) {
+    return Point(center.x + static_cast<float>(radiusX * std::cos(angle)),
+        center.y + static_cast<float>(radiusY * std::sin(angle)));
+}
+
+// Whether the corners of an unrounded shape lie within Tolerance of the
+// expected vertices, one corner for each
+bool hasVertices(
+    const RoundedPolygonShape& shape, const std::vector<Point>& expected) {
+    std::vector<Point> corners;
+    for (const auto& feature : shape.features()) {
+        if (!feature->isEdge()) {
+            const Cubic& cubic = feature->cubics().front();
+            corners.emplace_back(cubic.anchor0X(), cubic.anchor0Y());
+        }
+    }
+    if (corners.size() != expected.size()) {
+        return false;
+    }
+    for (const Point& vertex : expected) {
+        bool found = false;
+        for (const Point& corner : corners) {
+            found = found || (corner - vertex).getDistance() <= Tolerance;
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void testUnitCircle() {
+    constexpr size_t Counts[] = { 1, 3, 64, 10000 };
+    for (size_t count : Counts) {
+        const double start = 0.3;
+        const double step = 2.0 * Pi / static_cast<double>(count);
+        std::vector<float> cosines(count);
+        std::vector<float> sines(count);
+        unitCircle(count, start, step, cosines.data(), sines.data());
+        float error = 0.0f;
+        for (size_t i = 0; i < count; ++i) {
+            const double angle = start + step * static_cast<double>(i);
+            error = std::max({ error,
+                std::abs(cosines[i] - static_cast<float>(std::cos(angle))),
+                std::abs(sines[i] - static_cast<float>(std::sin(angle))) });
+        }
+        CHECK(error <= Tolerance);
+    }
+}
+
+void testRegularPolygons() {
+    constexpr int VertexCounts[] = { 3, 4, 5, 7, 12, 100, 500 };
+    const Point center(0.3f, -0.2f);
+    for (int count : VertexCounts) {
+        std::vector<Point> expected;
+        for (int i = 0; i < count; ++i) {
+            expected.push_back(polar(2.0 * Pi * i / count, 1.5, 1.5, center));
+        }
+        CHECK(hasVertices(
+            RoundedPolygonShape(count, 1.5f, center.x, center.y), expected));
+    }
+}
+
+void testStars() {
+    constexpr int VertexCounts[] = { 3, 5, 8, 50, 250 };
+    for (int count : VertexCounts) {
+        std::vector<Point> expected;
+        for (int i = 0; i < 2 * count; ++i) {
+            const double radius = i % 2 == 0 ? 1.0 : 0.4;
+            expected.push_back(
+                polar(Pi * i / count, radius, radius, Point(0.0f, 0.0f)));
+        }
+        CHECK(hasVertices(Shapes::star(count, 1.0f, 0.4f), expected));
+    }
+}
+
+void testPillStars() {
+    constexpr int VertexCounts[] = { 3, 8, 40 };
+    constexpr float Spacings[] = { 0.5f, 0.3f };
+    constexpr float Starts[] = { 0.0f, 0.1f };
+    for (int count : VertexCounts) {
+        for (float spacing : Spacings) {
+            for (float start : Starts) {
+                std::vector<Point> expected;
+                const int total = 2 * count;
+                for (int i = 0; i < total; ++i) {
+                    const bool outer = i % 2 == 0;
+                    const double index = static_cast<double>(i) +
+                        (outer ? 0.0 : static_cast<double>(spacing) - 0.5);
+                    const double angle = 2.0 * Pi * index / total +
+                        2.0 * Pi * static_cast<double>(start);
+                    const double scale = outer ? 1.0 : 0.5;
+                    expected.push_back(polar(
+                        angle, scale, 0.5 * scale, Point(0.0f, 0.0f)));
+                }
+                CHECK(hasVertices(Shapes::pillStar(2.0f, 1.0f, count, 0.5f,
+                                      CornerRounding::Unrounded, nullptr,
+                                      nullptr, spacing, start),
+                    expected));
+            }
+        }
+    }
+}
+
+// The points customPolygon() repeats, rotated around the center, and for
+// mirroring reflected across the line through the first point
+void testRepeats() {
+    const std::vector<MaterialShapes::PointNRound> points = {
+        { 1.0f, 0.5f }, { 0.8f, 0.56f }, { 0.76f, 0.6f }
+    };
+    const Point center(0.5f, 0.5f);
+    constexpr int Reps[] = { 2, 3, 8, 36 };
+    for (int reps : Reps) {
+        for (bool mirroring : { false, true }) {
+            std::vector<double> angles;
+            std::vector<double> distances;
+            for (const auto& point : points) {
+                const double dx = point.x - center.x;
+                const double dy = point.y - center.y;
+                angles.push_back(std::atan2(dy, dx));
+                distances.push_back(std::hypot(dx, dy));
+            }
+            const int sections = mirroring ? 2 * reps : reps;
+            const double section = 2.0 * Pi / sections;
+            std::vector<Point> expected;
+            for (int rep = 0; rep < sections; ++rep) {
+                for (size_t i = 0; i < points.size(); ++i) {
+                    const bool mirrored = mirroring && rep % 2 == 1;
+                    if (mirrored && i == 0) {
+                        continue;
+                    }
+                    const double angle = mirrored
+                        ? section * (rep + 1) - angles[i] + 2.0 * angles[0]
+                        : section * rep + angles[i];
+                    expected.push_back(
+                        polar(angle, distances[i], distances[i], center));
+                }
+            }
+            CHECK(hasVertices(MaterialShapes::customPolygon(
+                                  points, reps, center.x, center.y, mirroring),
+                expected));
+        }
+    }
+
+    // A first point on the center leaves no axis to mirror across, and
+    // mirrors across the x axis instead
+    const std::vector<MaterialShapes::PointNRound> centered = {
+        { 0.5f, 0.5f }, { 0.9f, 0.7f }, { 0.7f, 0.9f }
+    };
+    const RoundedPolygonShape shape =
+        MaterialShapes::customPolygon(centered, 2, 0.5f, 0.5f, true);
+    bool found = false;
+    for (const auto& feature : shape.features()) {
+        const Cubic& cubic = feature->cubics().front();
+        found = found ||
+            (Point(cubic.anchor0X(), cubic.anchor0Y()) - Point(0.9f, 0.3f))
+                    .getDistance() <= Tolerance;
+    }
+    CHECK(found);
+}
+
+// Whether each point of the cubics lies within maxError of the unit
+// superellipse, sampled densely along both axes for the nearest point
+void testSuperellipses() {
+    constexpr float Exponents[] = { 0.3f, 1.0f, 1.5f, 4.0f, 8.0f, 50.0f };
+    constexpr float MaxError = 1e-3f;
+    constexpr int Samples = 20000;
+    for (float exponent : Exponents) {
+        const auto n = static_cast<double>(exponent);
+        std::vector<Point> curve;
+        for (int i = 0; i <= Samples; ++i) {
+            const double u = static_cast<double>(i) / Samples;
+            const auto v =
+                static_cast<float>(std::pow(1.0 - std::pow(u, n), 1.0 / n));
+            curve.emplace_back(static_cast<float>(u), v);
+            curve.emplace_back(v, static_cast<float>(u));
+        }
+        const RoundedPolygonShape shape =
+            Shapes::superellipse(exponent, 1.0f, 1.0f, MaxError);
+        float error = 0.0f;
+        for (const Cubic& cubic : shape.cubics()) {
+            for (int i = 0; i <= 16; ++i) {
+                const Point p = cubic.pointOnCurve(static_cast<float>(i) / 16);
+                const Point quadrant(std::abs(p.x), std::abs(p.y));
+                float nearest = 1.0f;
+                for (const Point& q : curve) {
+                    nearest = std::min(nearest, (q - quadrant).getDistance());
+                }
+                error = std::max(error, nearest);
+            }
+        }
+        CHECK(error <= MaxError);
+    }
+}
+
+} // anonymous namespace
+
+int main() {
+    testUnitCircle();
+    testRegularPolygons();
+    testStars();
+    testPillStars();
+    testRepeats();
+    testSuperellipses();
+    return Check::result();
+}
@@ -0,0 +1,197 @@
+#include "Check.hpp"
+#include "shapes/MaterialShapes.hpp"
+#include "shapes/ShapePack.hpp"
+#include "shapes/SvgPath.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace RoundedPolygon;
+
+namespace {
+
+// Offsets into the pack format, see ShapePack.cpp
+constexpr size_t VersionOffset = 4;
+constexpr size_t HeaderSize = 32;
+constexpr size_t FirstCubicOffset = HeaderSize + 8;
+
+bool sameCubics(std::span<const Cubic> a, std::span<const Cubic> b) {
+    return a.size() == b.size() &&
+        std::memcmp(a.data(), b.data(), a.size_bytes()) == 0;
+}
+
+bool sameFloats(float a, float b) {
+    return std::memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+bool sameShape(const PackedShape& packed, const RoundedPolygonShape& shape) {
+    if (!sameCubics(packed.cubics(), shape.cubics()) ||
+        !sameFloats(packed.center().x, shape.centerX()) ||
+        !sameFloats(packed.center().y, shape.centerY()) ||
+        packed.featureCount() != shape.features().size()) {
+        return false;
+    }
+    const RoundedPolygonShape unpacked = packed.shape();
+    if (unpacked.features().size() != shape.features().size()) {
+        return false;
+    }
+    for (size_t i = 0; i < shape.features().size(); ++i) {
+        const Feature& a = *unpacked.features()[i];
+        const Feature& b = *shape.features()[i];
+        if (a.isEdge() != b.isEdge() ||
+            a.isConvexCorner() != b.isConvexCorner() ||
+            !sameCubics(a.cubics(), b.cubics())) {
+            return false;
+        }
+    }
+    const auto bounds = shape.calculateBounds(false);
+    for (size_t i = 0; i < bounds.size(); ++i) {
+        if (!sameFloats(packed.bounds()[i], bounds[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<std::pair<std::string, RoundedPolygonShape>> testShapes() {
+    std::vector<std::pair<std::string, RoundedPolygonShape>> shapes;
+    for (size_t i = 0; i < MaterialShapes::ShapeTypeCount; ++i) {
+        shapes.emplace_back("material" + std::to_string(i),
+            *MaterialShapes::getShape(
+                static_cast<MaterialShapes::ShapeType>(i)));
+    }
+    shapes.emplace_back("heart",
+        SvgPath::shape("M12 21.35l-1.45-1.32C5.4 15.36 2 12.28 2 8.5 "
+                       "2 5.42 4.42 3 7.5 3c1.74 0 3.41.81 4.5 2.09C13.09 "
+                       "3.81 14.76 3 16.5 3 19.58 3 22 5.42 22 8.5c0 "
+                       "3.78-3.4 6.86-8.55 11.54L12 21.35z"));
+    return shapes;
+}
+
+void checkPack(const ShapePack& pack,
+    const std::vector<std::pair<std::string, RoundedPolygonShape>>& shapes) {
+    CHECK(pack.size() == shapes.size());
+    for (size_t i = 0; i < shapes.size() && i < pack.size(); ++i) {
+        const auto& [name, shape] = shapes[i];
+        CHECK(pack.at(i).name() == name);
+        CHECK(sameShape(pack.at(i), shape));
+        auto found = pack.find(name);
+        CHECK(found && found->name() == name && sameShape(*found, shape));
+    }
+    CHECK(!pack.find("missing"));
+    CHECK(!pack.find(""));
+    CHECK_THROWS((void)pack.at(pack.size()), std::out_of_range);
+}
+
+void testRoundTrip(const std::filesystem::path& directory) {
+    const auto shapes = testShapes();
+    ShapePackWriter writer;
+    for (const auto& [name, shape] : shapes) {
+        writer.add(name, shape);
+    }
+    CHECK(writer.size() == shapes.size());
+    CHECK_THROWS(writer.add("heart", shapes.front().second),
+        std::invalid_argument);
+
+    const std::vector<std::byte> bytes = writer.bytes();
+    checkPack(ShapePack{ std::span<const std::byte>(bytes) }, shapes);
+
+    const std::string path = (directory / "shapes.m3sp").string();
+    writer.write(path);
+    ShapePack pack(path);
+    checkPack(pack, shapes);
+
+    // Shapes stay valid through copies of the pack
+    const PackedShape first = pack.at(0);
+    ShapePack copy = pack;
+    pack = ShapePack{ std::span<const std::byte>(bytes) };
+    CHECK(sameShape(first, shapes.front().second));
+    checkPack(copy, shapes);
+}
+
+void testEmptyPack() {
+    const std::vector<std::byte> bytes = ShapePackWriter().bytes();
+    ShapePack pack{ std::span<const std::byte>(bytes) };
+    CHECK(pack.size() == 0);
+    CHECK(!pack.find("any"));
+}
+
+void testDamagedData() {
+    ShapePackWriter writer;
+    writer.add("square", RoundedPolygonShape(4));
+    writer.add("circle",
+        *MaterialShapes::getShape(MaterialShapes::ShapeType::Circle));
+    const std::vector<std::byte> bytes = writer.bytes();
+
+    auto open = [](const std::vector<std::byte>& data) {
+        return ShapePack{ std::span<const std::byte>(data) };
+    };
+    CHECK(open(bytes).size() == 2);
+
+    // Every truncation, down to an empty buffer
+    for (size_t size = 0; size < bytes.size(); size += 4) {
+        std::vector<std::byte> truncated(bytes.begin(),
+            bytes.begin() + static_cast<std::ptrdiff_t>(size));
+        CHECK_THROWS(open(truncated), std::invalid_argument);
+    }
+
+    std::vector<std::byte> extended = bytes;
+    extended.resize(bytes.size() + 4);
+    CHECK_THROWS(open(extended), std::invalid_argument);
+
+    std::vector<std::byte> badMagic = bytes;
+    badMagic[0] = std::byte{ 'X' };
+    CHECK_THROWS(open(badMagic), std::invalid_argument);
+
+    std::vector<std::byte> badVersion = bytes;
+    badVersion[VersionOffset] = std::byte{ ShapePack::Version + 1 };
+    CHECK_THROWS(open(badVersion), std::invalid_argument);
+
+    // A shape whose cubics run past the end of the cubic table
+    std::vector<std::byte> badRecord = bytes;
+    const uint32_t firstCubic = 0xfffffff0u;
+    std::memcpy(&badRecord[FirstCubicOffset], &firstCubic, sizeof(uint32_t));
+    CHECK_THROWS(open(badRecord), std::invalid_argument);
+
+    // Data that is not 4-byte aligned
+    std::vector<std::byte> shifted(bytes.size() + 1);
+    std::memcpy(shifted.data() + 1, bytes.data(), bytes.size());
+    CHECK_THROWS(
+        (ShapePack{ std::span<const std::byte>(shifted).subspan(1) }),
+        std::invalid_argument);
+}
+
+void testFiles(const std::filesystem::path& directory) {
+    CHECK_THROWS(ShapePack((directory / "missing.m3sp").string()),
+        std::runtime_error);
+
+    const std::string damaged = (directory / "damaged.m3sp").string();
+    std::ofstream(damaged, std::ios::binary) << "M3SP";
+    CHECK_THROWS(ShapePack{ damaged }, std::invalid_argument);
+
+    ShapePackWriter writer;
+    writer.add("square", RoundedPolygonShape(4));
+    CHECK_THROWS(writer.write((directory / "missing" / "x.m3sp").string()),
+        std::runtime_error);
+}
+
+} // anonymous namespace
+
+int main() {
+    const std::filesystem::path directory =
+        std::filesystem::temp_directory_path() / "m3shapes_shape_pack_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    testRoundTrip(directory);
+    testEmptyPack();
+    testDamagedData();
+    testFiles(directory);
+
+    std::filesystem::remove_all(directory);
+    return Check::result();
+}
@@ -0,0 +1,190 @@
+#include "Check.hpp"
+#include "shapes/SvgPath.hpp"
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace RoundedPolygon;
+
+namespace {
+
+struct Corners {
+    size_t convex = 0;
+    size_t concave = 0;
+};
+
+Corners corners(const RoundedPolygonShape& shape) {
+    Corners result;
+    for (const auto& feature : shape.features()) {
+        if (feature->isConvexCorner()) {
+            ++result.convex;
+        } else if (feature->isConcaveCorner()) {
+            ++result.concave;
+        }
+    }
+    return result;
+}
+
+bool near(float a, float b) {
+    return std::abs(a - b) < 1e-4f;
+}
+
+bool nearPoint(float x, float y, const Point& point) {
+    return near(x, point.x) && near(y, point.y);
+}
+
+// Whether some cubic of shape leaves or reaches anchor through control, in
+// whichever direction the shape was turned to run
+bool hasJoin(const RoundedPolygonShape& shape, const Point& anchor,
+    const Point& control) {
+    for (const auto& cubic : shape.cubics()) {
+        if ((nearPoint(cubic.anchor0X(), cubic.anchor0Y(), anchor) &&
+                nearPoint(cubic.control0X(), cubic.control0Y(), control)) ||
+            (nearPoint(cubic.anchor1X(), cubic.anchor1Y(), anchor) &&
+                nearPoint(cubic.control1X(), cubic.control1Y(), control))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Whether the outlines of two shapes have the same anchors and controls
+bool sameOutline(const RoundedPolygonShape& a, const RoundedPolygonShape& b) {
+    if (a.cubics().size() != b.cubics().size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.cubics().size(); ++i) {
+        for (size_t j = 0; j < 8; ++j) {
+            if (!near(a.cubics()[i].points()[j], b.cubics()[i].points()[j])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Whether importing pathData throws naming offset
+bool failsAt(std::string_view pathData, size_t offset) {
+    try {
+        (void)SvgPath::shapes(pathData);
+    } catch (const std::invalid_argument& error) {
+        return std::string(error.what()).ends_with(
+            "offset " + std::to_string(offset));
+    }
+    return false;
+}
+
+// The same square in absolute, relative, implicit and comma separated
+// forms, and drawn the other way round
+void testSquare() {
+    const RoundedPolygonShape square = SvgPath::shape("M0 0H10V10H0Z");
+    // Four edges and the empty cubics of four sharp corners
+    CHECK(square.features().size() == 8);
+    CHECK(square.cubics().size() == 4);
+    CHECK(corners(square).convex == 4 && corners(square).concave == 0);
+    const auto bounds = square.calculateBounds(false);
+    CHECK(near(bounds[0], 0.0f) && near(bounds[1], 0.0f) &&
+        near(bounds[2], 10.0f) && near(bounds[3], 10.0f));
+    CHECK(near(square.centerX(), 5.0f) && near(square.centerY(), 5.0f));
+
+    for (std::string_view same :
+        { "m0 0h10v10h-10z", "M0,0 L10,0 L10,10 L0,10 Z",
+            "M0 0L10 0 10 10 0 10z", " \n M 0 , 0 l 10 0 0 10 -10 0 z \t",
+            "M+0-0H1e1V.1e2H0z" }) {
+        CHECK(sameOutline(SvgPath::shape(same), square));
+    }
+
+    const RoundedPolygonShape reversed = SvgPath::shape("M0 0V10H10V0Z");
+    CHECK(corners(reversed).convex == 4 && corners(reversed).concave == 0);
+}
+
+void testNumbers() {
+    // Signs and points separate numbers without spaces
+    const RoundedPolygonShape triangle = SvgPath::shape("M.5.5L10.5.5-4.5-9z");
+    const auto& cubics = triangle.cubics();
+    CHECK(corners(triangle).convex == 3);
+    bool found = false;
+    for (const auto& cubic : cubics) {
+        found = found ||
+            nearPoint(cubic.anchor0X(), cubic.anchor0Y(), Point(-4.5f, -9.0f));
+    }
+    CHECK(found);
+}
+
+void testCurves() {
+    // S reflects the second control point of the previous cubic
+    const RoundedPolygonShape smooth =
+        SvgPath::shape("M0 0C0 5 5 10 10 10S20 5 20 0Z");
+    CHECK(hasJoin(smooth, Point(10, 10), Point(15, 10)));
+
+    // T reflects the control point of the previous quadratic, which becomes
+    // the cubic's controls two thirds of the way to it
+    const RoundedPolygonShape quadratic =
+        SvgPath::shape("M0 0Q5 -9 10 0T20 0Z");
+    CHECK(hasJoin(quadratic, Point(10, 0), Point(40.0f / 3.0f, 6)));
+
+    // Two half circles make a circle without corners, with its flags
+    // written without separators
+    const RoundedPolygonShape circle =
+        SvgPath::shape("M10 0A10 10 0 11-10 0A10 10 0 1110 0Z");
+    CHECK(corners(circle).convex == 0 && corners(circle).concave == 0);
+    for (const auto& cubic : circle.cubics()) {
+        CHECK(std::abs(std::hypot(cubic.anchor0X(), cubic.anchor0Y()) -
+                  10.0f) < 1e-3f);
+        const Point middle = cubic.pointOnCurve(0.5f);
+        CHECK(std::abs(std::hypot(middle.x, middle.y) - 10.0f) < 2e-2f);
+    }
+}
+
+void testCorners() {
+    const RoundedPolygonShape star = SvgPath::shape(
+        "M0-10L2.9-4 9.5-3.1 4.7 1.5 5.9 8.1 0 5-5.9 8.1-4.7 1.5-9.5-3.1"
+        "-2.9-4Z");
+    CHECK(corners(star).convex == 5 && corners(star).concave == 5);
+
+    // A join turning by 2 degrees is only a corner when cornerAngle is less
+    const std::string_view nearlySmooth = "M0 0L10 0L20 0.35L20 10L0 10Z";
+    CHECK(corners(SvgPath::shape(nearlySmooth)).convex == 4);
+    CHECK(corners(SvgPath::shape(nearlySmooth, FloatPi / 180.0f)).convex ==
+        5);
+}
+
+void testSubpaths() {
+    CHECK(SvgPath::shapes("").empty());
+    CHECK(SvgPath::shapes("M0 0Z").empty());
+    CHECK(SvgPath::shapes("M0 0H1V1Z M5 5H6V6Z").size() == 2);
+    CHECK(SvgPath::shapes("M0 0H1V1Zm0 0h1v1z").size() == 2);
+    CHECK(SvgPath::shapes("M0 0 M1 1H2V2Z").size() == 1);
+    CHECK_THROWS((void)SvgPath::shape(""), std::invalid_argument);
+    CHECK_THROWS(
+        (void)SvgPath::shape("M0 0H1V1Z M5 5H6V6Z"), std::invalid_argument);
+}
+
+void testMalformed() {
+    CHECK(failsAt("M", 1));
+    CHECK(failsAt("M1", 2));
+    CHECK(failsAt("L1 1H2V2Z", 0));
+    CHECK(failsAt("M0 0L", 5));
+    CHECK(failsAt("M0 0L1,", 7));
+    CHECK(failsAt("M0 0L1 1 X", 9));
+    CHECK(failsAt("M nan 0", 2));
+    CHECK(failsAt("Minf 0", 1));
+    CHECK(failsAt("M1e 0", 2));
+    CHECK(failsAt("M0 0H1,,2", 7));
+    CHECK(failsAt("M0 0--1", 4));
+    CHECK(failsAt("M0 0A1 1 0 2 0 1 1Z", 11));
+}
+
+} // anonymous namespace
+
+int main() {
+    testSquare();
+    testNumbers();
+    testCurves();
+    testCorners();
+    testSubpaths();
+    testMalformed();
+    return Check::result();
+}
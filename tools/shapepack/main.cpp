@@ -0,0 +1,147 @@
+#include "shapes/MaterialShapes.hpp"
+#include "shapes/ShapePack.hpp"
+#include "shapes/SvgPath.hpp"
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+using namespace RoundedPolygon;
+
+namespace {
+
+using ShapeType = MaterialShapes::ShapeType;
+
+// Built-in shapes, named as in the QML Shape enum
+struct NamedShape {
+    const char* name;
+    ShapeType type;
+};
+
+constexpr NamedShape MaterialShapeNames[] = { { "Circle", ShapeType::Circle },
+    { "Square", ShapeType::Square }, { "Slanted", ShapeType::Slanted },
+    { "Arch", ShapeType::Arch }, { "Fan", ShapeType::Fan },
+    { "Arrow", ShapeType::Arrow }, { "SemiCircle", ShapeType::SemiCircle },
+    { "Oval", ShapeType::Oval }, { "Pill", ShapeType::Pill },
+    { "Triangle", ShapeType::Triangle }, { "Diamond", ShapeType::Diamond },
+    { "ClamShell", ShapeType::ClamShell },
+    { "Pentagon", ShapeType::Pentagon }, { "Gem", ShapeType::Gem },
+    { "Sunny", ShapeType::Sunny }, { "VerySunny", ShapeType::VerySunny },
+    { "Cookie4Sided", ShapeType::Cookie4Sided },
+    { "Cookie6Sided", ShapeType::Cookie6Sided },
+    { "Cookie7Sided", ShapeType::Cookie7Sided },
+    { "Cookie9Sided", ShapeType::Cookie9Sided },
+    { "Cookie12Sided", ShapeType::Cookie12Sided },
+    { "Ghostish", ShapeType::Ghostish },
+    { "Clover4Leaf", ShapeType::Clover4Leaf },
+    { "Clover8Leaf", ShapeType::Clover8Leaf }, { "Burst", ShapeType::Burst },
+    { "SoftBurst", ShapeType::SoftBurst }, { "Boom", ShapeType::Boom },
+    { "SoftBoom", ShapeType::SoftBoom }, { "Flower", ShapeType::Flower },
+    { "Puffy", ShapeType::Puffy },
+    { "PuffyDiamond", ShapeType::PuffyDiamond },
+    { "PixelCircle", ShapeType::PixelCircle },
+    { "PixelTriangle", ShapeType::PixelTriangle }, { "Bun", ShapeType::Bun },
+    { "Heart", ShapeType::Heart } };
+
+static_assert(std::size(MaterialShapeNames) == MaterialShapes::ShapeTypeCount);
+
+constexpr const char* Usage =
+    "Usage: shape_pack [options] OUTPUT\n"
+    "       shape_pack --list PACK\n"
+    "\n"
+    "Writes the shapes given by the options to the shape pack OUTPUT, in\n"
+    "the order they are given.\n"
+    "\n"
+    "  --material    Add the built-in Material shapes, named as in QML\n"
+    "  --svg FILE    Add a shape for each line of FILE, written as a name\n"
+    "                and SVG path data separated by whitespace. Blank\n"
+    "                lines and lines starting with # are skipped.\n"
+    "  --normalize   Fit the shapes of the following --svg files into the\n"
+    "                unit square, like the built-in shapes\n"
+    "  --list PACK   Print the shapes of PACK instead\n";
+
+void addSvgFile(ShapePackWriter& writer, const std::string& path,
+    bool normalize) {
+    std::ifstream input(path);
+    if (!input) {
+        throw std::runtime_error("Cannot read " + path);
+    }
+    std::string line;
+    for (size_t number = 1; std::getline(input, line); ++number) {
+        std::string_view text(line);
+        size_t nameStart = text.find_first_not_of(" \t\r");
+        if (nameStart == std::string_view::npos || text[nameStart] == '#') {
+            continue;
+        }
+        size_t nameEnd = text.find_first_of(" \t", nameStart);
+        if (nameEnd == std::string_view::npos) {
+            throw std::runtime_error(path + ":" + std::to_string(number) +
+                ": Missing path data");
+        }
+        try {
+            RoundedPolygonShape shape = SvgPath::shape(text.substr(nameEnd));
+            writer.add(std::string(text.substr(nameStart, nameEnd - nameStart)),
+                normalize ? shape.normalized() : shape);
+        } catch (const std::invalid_argument& error) {
+            throw std::runtime_error(
+                path + ":" + std::to_string(number) + ": " + error.what());
+        }
+    }
+}
+
+void list(const std::string& path) {
+    ShapePack pack(path);
+    for (size_t i = 0; i < pack.size(); ++i) {
+        PackedShape shape = pack.at(i);
+        auto bounds = shape.bounds();
+        std::printf("%.*s: %zu cubics, %zu features, bounds %g %g %g %g\n",
+            static_cast<int>(shape.name().size()), shape.name().data(),
+            shape.cubics().size(), shape.featureCount(),
+            static_cast<double>(bounds[0]), static_cast<double>(bounds[1]),
+            static_cast<double>(bounds[2]), static_cast<double>(bounds[3]));
+    }
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        ShapePackWriter writer;
+        bool normalize = false;
+        std::string output;
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg(argv[i]);
+            bool hasValue = i + 1 < argc;
+            if (arg == "--material") {
+                for (const auto& [name, type] : MaterialShapeNames) {
+                    writer.add(name, *MaterialShapes::getShape(type));
+                }
+            } else if (arg == "--svg" && hasValue) {
+                addSvgFile(writer, argv[++i], normalize);
+            } else if (arg == "--normalize") {
+                normalize = true;
+            } else if (arg == "--list" && hasValue && argc == 3) {
+                list(argv[++i]);
+                return 0;
+            } else if (!arg.starts_with("--") && output.empty()) {
+                output = arg;
+            } else {
+                std::fputs(Usage, stderr);
+                return 2;
+            }
+        }
+        if (output.empty()) {
+            std::fputs(Usage, stderr);
+            return 2;
+        }
+        writer.write(output);
+        std::printf("Wrote %zu shapes to %s\n", writer.size(), output.c_str());
+    } catch (const std::exception& error) {
+        std::fprintf(stderr, "shape_pack: %s\n", error.what());
+        return 1;
+    }
+    return 0;
+}